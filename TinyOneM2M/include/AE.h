@@ -35,10 +35,10 @@ typedef struct {
 
 
 AEStruct *init_ae();
-char create_ae(AEStruct * ae, cJSON *content, char** response);
+char create_ae(AEStruct * ae, cJSON *content, HTTPResponse *response);
 
 cJSON *ae_to_json(const AEStruct *ae);
 
-char update_ae(struct Route* destination, cJSON *content, char** response);
+char update_ae(struct Route* destination, cJSON *content, HTTPResponse *response);
 
-char get_ae(struct Route* destination, char** response);
\ No newline at end of file
+char get_ae(struct Route* destination, HTTPResponse *response);
\ No newline at end of file
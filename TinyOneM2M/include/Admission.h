@@ -0,0 +1,28 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include "HTTP_Response.h"
+
+// Serves the admission counters as JSON, next to the static routes
+#define ADMISSION_STATUS_ROUTE "/status"
+
+// Connection and request budgets shared by every reactor. A client over budget
+// gets a canned 503 and is closed instead of waiting behind everyone else.
+char admission_connection_open(void);
+void admission_connection_closed(void);
+char admission_request_begin(void);
+void admission_request_started(void);
+void admission_request_end(void);
+void admission_reject(int socket_desc);
+void admission_status(HTTPResponse *response);
+
+#endif
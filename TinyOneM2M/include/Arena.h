@@ -0,0 +1,37 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Size of the block every thread keeps between requests
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;
+    size_t used;
+} ArenaBlock;
+
+// Bump allocator for one request. Nothing is freed on its own, everything goes
+// at once when the request is over.
+typedef struct Arena {
+    ArenaBlock *blocks; // newest first, the last one is the kept block
+    char active;
+} Arena;
+
+void init_arena_hooks(void);
+void arena_begin(void);
+void arena_end(void);
+void *arena_alloc(size_t size);
+char *arena_strdup(const char *s);
+
+#endif
@@ -31,8 +31,9 @@ typedef struct {
 } CINStruct;
 
 CINStruct *init_cin();
-char create_cin(sqlite3 *db, CINStruct * cin, cJSON *content, char** response);
+char create_cin(sqlite3 *db, CINStruct * cin, cJSON *content, HTTPResponse *response);
+char evict_cin_instances(sqlite3 *db, const char *cnt_ri, int *cni, int mni, int *cbs, int mbs);
 
 cJSON *cin_to_json(const CINStruct *cin);
 
-char get_cin(struct Route* destination, char** response);
\ No newline at end of file
+char get_cin(struct Route* destination, HTTPResponse *response);
\ No newline at end of file
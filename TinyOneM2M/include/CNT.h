@@ -34,10 +34,11 @@ typedef struct {
 } CNTStruct;
 
 CNTStruct *init_cnt();
-char create_cnt(CNTStruct * cnt, cJSON *content, char** response);
+char create_cnt(CNTStruct * cnt, cJSON *content, HTTPResponse *response);
 
 cJSON *cnt_to_json(const CNTStruct *cnt);
+char *render_cnt(const char *blob, int cni, int cbs);
 
-char update_cnt(struct Route* destination, cJSON *content, char** response);
+char update_cnt(struct Route* destination, cJSON *content, HTTPResponse *response);
 
-char get_cnt(struct Route* destination, char** response);
\ No newline at end of file
+char get_cnt(struct Route* destination, HTTPResponse *response);
\ No newline at end of file
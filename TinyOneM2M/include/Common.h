@@ -24,6 +24,19 @@
 #include "Signals.h"
 #include "Routes.h"
 #include "MTC_Protocol.h"
+#include "Worker_Pool.h"
+#include "Reactor.h"
+#include "Mongoose_Server.h"
+#include "Static_Cache.h"
+#include "Admission.h"
+#include "Arena.h"
+#include "Timer_Wheel.h"
+#include "Epoch.h"
+#include "Route_Cache.h"
+#include "Route_Snapshot.h"
+#include "Slab.h"
+#include "Id_Allocator.h"
+#include "Expiration_Reaper.h"
 
 
 
@@ -0,0 +1,36 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stdatomic.h>
+
+typedef void (*retire_fn)(void *ptr);
+
+// One per thread that ever read shared data inside epoch_enter/epoch_exit
+typedef struct EpochThread {
+    atomic_ulong epoch; // global epoch seen on entry
+    atomic_int active;
+    struct EpochThread *next;
+} EpochThread;
+
+// Memory waiting for every reader that could still see it to leave
+typedef struct EpochRetired {
+    void *ptr;
+    retire_fn release;
+    unsigned long epoch;
+    struct EpochRetired *next;
+} EpochRetired;
+
+void epoch_enter(void);
+void epoch_exit(void);
+void epoch_retire(void *ptr, retire_fn release);
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef EXPIRATION_REAPER_H
+#define EXPIRATION_REAPER_H
+
+struct RouteTable;
+
+// A resource past its et, copied out of the database before it is deleted
+typedef struct ExpiredResource {
+    char *ri;
+    short ty;
+    char *pi;
+    char *key; // its route, the lowercase url
+    int cs;
+    char *blob;
+} ExpiredResource;
+
+int reap_expired(struct RouteTable *table, int batch_size);
+char start_expiration_reaper(struct RouteTable *table);
+
+#endif
@@ -0,0 +1,75 @@
+/*
+ * Created on Tue Oct 13 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <stddef.h>
+
+#define HTTP_MAX_HEADERS 32
+#define HTTP_MAX_HEAD_SIZE 16384
+
+// http_parse_request results
+#define HTTP_PARSE_TOO_LARGE -2
+#define HTTP_PARSE_ERROR -1
+#define HTTP_PARSE_INCOMPLETE 0
+#define HTTP_PARSE_DONE 1
+
+// Parser states
+#define HTTP_STATE_HEAD 0
+#define HTTP_STATE_BODY 1
+#define HTTP_STATE_CHUNK_SIZE 2
+#define HTTP_STATE_CHUNK_DATA 3
+#define HTTP_STATE_CHUNK_END 4
+#define HTTP_STATE_TRAILER 5
+#define HTTP_STATE_DONE 6
+
+// A piece of the receive buffer. Offsets instead of pointers, the buffer may be
+// reallocated while a request is still arriving.
+typedef struct {
+    size_t offset;
+    size_t length;
+} HTTPSlice;
+
+typedef struct {
+    HTTPSlice name;
+    HTTPSlice value;
+} HTTPHeader;
+
+// One request parsed in place. Once the head is complete the method, path, query,
+// version and header slices are NUL terminated inside the buffer, so they can be
+// used as C strings. The body is not terminated (the next pipelined request may
+// follow it); a chunked body is joined in place so it is always contiguous.
+typedef struct HTTPRequest {
+    int state;
+    size_t scanned; // bytes of the buffer already looked at
+    size_t chunk_remaining;
+
+    HTTPSlice method;
+    HTTPSlice path;
+    HTTPSlice query;
+    HTTPSlice version;
+    HTTPHeader headers[HTTP_MAX_HEADERS];
+    int num_headers;
+
+    size_t content_length;
+    char chunked;
+    char keep_alive;
+    HTTPSlice body;
+
+    size_t length; // bytes this request takes in the buffer, set when done
+} HTTPRequest;
+
+void http_request_reset(HTTPRequest *request);
+int http_parse_request(HTTPRequest *request, char *buffer, size_t length, size_t max_size);
+const char *http_get_header(const HTTPRequest *request, const char *buffer, const char *name);
+
+#define http_slice(buffer, slice) ((buffer) + (slice).offset)
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Created on Wed Oct 14 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef HTTP_RESPONSE_H
+#define HTTP_RESPONSE_H
+
+#include <stddef.h>
+
+#define HTTP_RESPONSE_MAX_SLICES 8
+#define HTTP_RESPONSE_HEADERS_SIZE 256
+// Room for the status line, the header lines and the framing headers
+#define HTTP_RESPONSE_HEAD_SIZE (HTTP_RESPONSE_HEADERS_SIZE + 256)
+
+typedef void (*release_fn)(void *data);
+
+// Part of the body. Slices are sent where they are, release (when not NULL)
+// is called on data once the response is done with it.
+typedef struct {
+    const char *data;
+    size_t length;
+    release_fn release;
+} HTTPBodySlice;
+
+// A response is a status line, a few header lines and a list of body slices,
+// written with a single sendmsg. Content-Length and Connection are added on send.
+typedef struct HTTPResponse {
+    int status_code;
+    char status_line[64];
+    const char *content_type; // static string or NULL
+    char headers[HTTP_RESPONSE_HEADERS_SIZE];
+    size_t headers_length;
+
+    HTTPBodySlice slices[HTTP_RESPONSE_MAX_SLICES];
+    int num_slices;
+    size_t body_length;
+} HTTPResponse;
+
+void http_response_init(HTTPResponse *response);
+void http_response_reset(HTTPResponse *response);
+void http_response_status(HTTPResponse *response, int status_code, const char *status_message, const char *content_type);
+char http_response_header(HTTPResponse *response, const char *name, const char *value);
+char http_response_body(HTTPResponse *response, const char *data, size_t length, release_fn release);
+char http_response_json(HTTPResponse *response, int status_code, const char *status_message, char *json, release_fn release);
+size_t http_response_head(HTTPResponse *response, char *head, size_t size, char keep_alive);
+char http_response_send(HTTPResponse *response, int socket_desc, char keep_alive);
+
+#endif
@@ -11,12 +11,19 @@
 #ifndef HTTP_SERVER_H
 #define HTTP_SERVER_H
 
+// One listening socket per listener, all bound to the same port with SO_REUSEPORT
+// so the kernel spreads incoming connections between them
 typedef struct HTTP_Server {
-	int socket;
+	int socket; // first listener
 	int port;	
+	int *sockets;
+	int num_sockets;
 } HTTP_Server;
 
 
+int lock_instance(const char *path);
 void init_server(HTTP_Server* http_server, int port);
+void close_server(HTTP_Server* http_server);
+void configure_client_socket(int client_socket);
 
 #endif
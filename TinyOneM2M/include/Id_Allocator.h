@@ -0,0 +1,19 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef ID_ALLOCATOR_H
+#define ID_ALLOCATOR_H
+
+#include <stddef.h>
+#include <sqlite3.h>
+
+char init_id_allocator(void);
+char allocate_id(sqlite3 *db, short ty, char *ri, size_t size);
+
+#endif
@@ -38,22 +38,23 @@
 #define TSB     60
 #define ACTR    63
 
-char init_protocol(struct Route** head);
-char retrieve_csebase(struct Route * destination, char **response);
-char discovery(struct Route *head, struct Route *destination, const char *queryString, char **response);
-char post_ae(struct Route** route, struct Route* destination, cJSON *content, char** response);
-char post_cnt(struct Route** route, struct Route* destination, cJSON *content, char** response);
-char post_cin(struct Route** route, struct Route* destination, cJSON *content, char** response);
-char post_sub(struct Route** head, struct Route* destination, cJSON *content, char** response);
-char retrieve_ae(struct Route * destination, char **response);
-char retrieve_cnt(struct Route * destination, char **response);
-char retrieve_cin(struct Route * destination, char **response);
-char retrieve_sub(struct Route * destination, char **response);
+char init_protocol(RouteTable *routes);
+char retrieve_csebase(struct Route * destination, HTTPResponse *response);
+char discovery(RouteTable *routes, struct Route *destination, const char *queryString, HTTPResponse *response);
+char post_ae(RouteTable *routes, struct Route* destination, cJSON *content, HTTPResponse *response);
+char post_cnt(RouteTable *routes, struct Route* destination, cJSON *content, HTTPResponse *response);
+char post_cin(RouteTable *routes, struct Route* destination, cJSON *content, HTTPResponse *response);
+char post_sub(RouteTable *routes, struct Route* destination, cJSON *content, HTTPResponse *response);
+char retrieve_ae(struct Route * destination, HTTPResponse *response);
+char retrieve_cnt(struct Route * destination, HTTPResponse *response);
+char retrieve_cin(struct Route * destination, HTTPResponse *response);
+char retrieve_sub(struct Route * destination, HTTPResponse *response);
 char validate_keys(cJSON *object, char *keys[], int num_keys, char **response);
-char delete_resource(struct Route * destination, char **response);
-char put_ae(struct Route* destination, cJSON *content, char** response);
-char put_cnt(struct Route* destination, cJSON *content, char** response);
-char put_sub(struct Route* destination, cJSON *content, char** response);
+char delete_resource(RouteTable *routes, struct Route * destination, HTTPResponse *response);
+void notify_subscribers(sqlite3 *db, const char *pi, const char *blob, const char *event);
+char put_ae(struct Route* destination, cJSON *content, HTTPResponse *response);
+char put_cnt(struct Route* destination, cJSON *content, HTTPResponse *response);
+char put_sub(struct Route* destination, cJSON *content, HTTPResponse *response);
 char *get_element_value_as_string(cJSON *element);
 cJSON *build_json_recursively(sqlite3 *db, int parent_rowid, char is_root_array);
 char has_disallowed_keys(cJSON *json_object, const char **allowed_keys, size_t num_allowed_keys);
@@ -0,0 +1,21 @@
+/*
+ * Created on Thu Oct 15 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef MONGOOSE_SERVER_H
+#define MONGOOSE_SERVER_H
+
+#define MONGOOSE_POLL_MS 1000
+
+struct RouteTable;
+
+// Serves the oneM2M API from the bundled Mongoose event loop (SERVER_MODE = mongoose).
+// Everything runs on the calling thread; it only returns if the listener can not be opened.
+char run_mongoose_server(int port, struct RouteTable *routes);
+
+#endif
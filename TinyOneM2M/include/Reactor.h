@@ -0,0 +1,41 @@
+/*
+ * Created on Mon Oct 12 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <pthread.h>
+
+#include "Worker_Pool.h"
+#include "Timer_Wheel.h"
+
+#define REACTOR_MAX_EVENTS 64
+// How often waiting connections are checked against their deadline
+#define REACTOR_SWEEP_MS 1000
+
+struct ConnectionInfo;
+
+// One epoll loop: accepts on listen_fd and hands readable clients to the pool
+typedef struct Reactor {
+    int epoll_fd;
+    int listen_fd;
+    pthread_t thread;
+    WorkerPool *pool;
+    struct RouteTable *routes;
+
+    // deadlines of the connections waiting for data, workers re-arm under the lock
+    pthread_mutex_t lock;
+    TimerWheel timers;
+} Reactor;
+
+char init_reactor(Reactor *reactor, int listen_fd, WorkerPool *pool, struct RouteTable *routes);
+char start_reactor(Reactor *reactor);
+void reactor_rearm(Reactor *reactor, struct ConnectionInfo *info);
+
+#endif
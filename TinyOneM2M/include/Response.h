@@ -8,17 +8,36 @@
  */
 
 #include <stdlib.h>
+#include <time.h>
+#include <sys/types.h>
 
-typedef struct {
+#include "HTTP_Parser.h"
+#include "HTTP_Response.h"
+#include "Timer_Wheel.h"
+
+typedef struct ConnectionInfo {
     int socket_desc;
-    struct Route * route;
-} ConnectionInfo;
+    struct RouteTable * routes;
+    struct Reactor * reactor;
 
-char * render_static_file(char* fileName);
+    // bytes received but not yet consumed by a request (pipelining leaves leftovers)
+    char *buffer;
+    size_t buffer_size;
+    size_t buffer_len;
+    HTTPRequest request; // request being parsed at the start of buffer
+
+    // deadline while the connection waits in the reactor, idle or part way through a request
+    TimerNode timer;
+    time_t request_started; // first bytes of the buffered request, 0 when none
+    time_t body_started; // head of the buffered request was complete, 0 when not yet
+} ConnectionInfo;
 
-void *handle_connection(void *connectioninfo);
+void handle_connection(void *connectioninfo);
+void close_connection(ConnectionInfo *info);
+void dispatch_request(ConnectionInfo *info, char *method, char *urlRoute, char *queryString, const char *body, size_t body_length, const char *if_none_match, HTTPResponse *response);
+void process_request(ConnectionInfo *info, HTTPRequest *request, HTTPResponse *response);
 
-void responseMessage(char** response, int status_code, char* status_message, char* message);
+void responseMessage(HTTPResponse *response, int status_code, char* status_message, char* message);
 
-cJSON *get_json_from_request(const char *request);
+cJSON *get_json_from_request(const char *body, size_t length);
 cJSON *get_first_child(cJSON *json_object);
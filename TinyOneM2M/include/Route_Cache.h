@@ -0,0 +1,40 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef ROUTE_CACHE_H
+#define ROUTE_CACHE_H
+
+#include <stddef.h>
+
+struct Route;
+
+typedef struct RouteCacheEntry {
+    struct Route *route;
+    struct RouteCacheEntry *hash_next;
+    struct RouteCacheEntry *prev, *next; // most recently used first
+} RouteCacheEntry;
+
+// Routes to CINs, which the route table leaves out. Loaded from the database on
+// a miss, the least recently used one goes when the cache is full.
+typedef struct RouteCache {
+    RouteCacheEntry **buckets;
+    size_t num_buckets; // power of two
+    size_t count;
+    size_t capacity;
+    RouteCacheEntry *head, *tail;
+} RouteCache;
+
+char init_route_cache(int capacity);
+void free_route_cache(void);
+struct Route *route_cache_find(const char *key, const struct Route *container);
+struct Route *route_cache_add(const char *key, const char *ri, short ty, const char *rn);
+void route_cache_remove(const char *key);
+void route_cache_remove_below(const char *key);
+
+#endif
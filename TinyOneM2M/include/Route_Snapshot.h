@@ -0,0 +1,46 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef ROUTE_SNAPSHOT_H
+#define ROUTE_SNAPSHOT_H
+
+#include <stdint.h>
+
+#define ROUTE_SNAPSHOT_FILE "tiny-oneM2M.routes"
+#define ROUTE_SNAPSHOT_MAGIC "TOM2RTS1"
+#define ROUTE_SNAPSHOT_VERSION 1
+
+struct RouteTable;
+
+// The file is the header, count entries and then the strings they point into.
+// It is only used when database_id and generation match the database.
+typedef struct RouteSnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    int64_t database_id;
+    int64_t generation; // bumped by a trigger on every non-CIN insert or delete in mtc_meta
+    uint64_t strings_size;
+} RouteSnapshotHeader;
+
+typedef struct RouteSnapshotEntry {
+    uint32_t key; // offsets into the strings
+    uint32_t ri;
+    uint32_t value;
+    int16_t ty;
+    uint16_t reserved;
+} RouteSnapshotEntry;
+
+char init_route_snapshots(struct RouteTable *table);
+char load_route_snapshot(struct RouteTable *table);
+char write_route_snapshot(struct RouteTable *table);
+char start_route_snapshots(struct RouteTable *table);
+void stop_route_snapshots(void);
+
+#endif
@@ -9,25 +9,75 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
+#define ROUTE_TABLE_INITIAL_CAPACITY 1024
+
+typedef _Atomic(struct Route *) RouteSlot;
+
+// Routes never change once they are reachable, only their links do. Readers
+// walk them without locks inside epoch_enter/epoch_exit.
 struct Route {
 	char* key;
 	char* ri; // resource ID
 	short ty; // resource type
 	char* value;
+	unsigned long hash; // of key, kept so probing and growing never rehash strings
+	unsigned long ri_hash, rn_hash; // in the ri and (rn, ty) indexes
+	char indexed; // la/ol and the templates are left out of both
 
-	struct Route *left, *right;
+	// Resource tree, one node per path segment: /onem2m/ae1/cnt1 is a child of
+	// /onem2m/ae1. Children are kept in creation order, oldest first.
+	RouteSlot parent;
+	RouteSlot first_child, last_child;
+	RouteSlot prev_sibling, next_sibling;
+	int num_children;
 };
 
+// One generation of the open addressing arrays, replaced as a whole when it grows
+typedef struct RouteSlots {
+	size_t capacity; // power of two
+	size_t used, ri_used, rn_used; // slots holding a route or a deleted marker
+	RouteSlot *by_key; // lowercase URL
+	RouteSlot *by_ri; // ri compared case insensitively
+	RouteSlot *by_rn; // rn and ty, several routes can share them
+} RouteSlots;
+
+// Hash indexes over every route, for lookups, plus the resource tree the routes
+// form, for walks over a resource's children. Writers take turns on write_lock,
+// readers never wait for them.
+typedef struct RouteTable {
+	_Atomic(RouteSlots *) slots;
+	size_t count; // routes in the table
+	RouteSlot first_root, last_root; // routes without a parent ("/" and orphans)
+	atomic_ulong change_seq; // bumped when a POST/DELETE that changes routes starts and ends
+	atomic_int changes_in_flight;
+	pthread_mutex_t write_lock;
+} RouteTable;
+
 struct Route * initRoute(char* key, char* ri, short ty, char* value);
+void free_route(void *route);
+unsigned long route_hash(const char *key);
+
+char init_route_table(RouteTable *table);
+void free_route_table(RouteTable *table);
+struct Route *addRoute(RouteTable *table, char *key, char *ri, short ty, char *value);
+void removeRoute(RouteTable *table, struct Route *route);
+void remove_subtree(RouteTable *table, struct Route *route);
+struct Route *route_next(const struct Route *route, const struct Route *subtree);
 
-struct Route *addRoute(struct Route **head, char *key, char *ri, short ty, char *value);
+struct Route* search(RouteTable *table, const char *key);
+struct Route *resolve_route(RouteTable *table, char *key);
+struct Route* search_byri(RouteTable *table, const char* ri);
+struct Route *resolve_ri(RouteTable *table, const char *ri);
+struct Route * search_byrn_ty(RouteTable *table, char* rn, short ty);
+int count_same_types(RouteTable *table, int type);
 
-struct Route* search(struct Route *root, const char *key);
-struct Route* search_byri(struct Route* head, const char* ri);
-struct Route * search_byrn_ty(struct Route * root, char* rn, short ty);
-int count_same_types(struct Route* head, int type);
+void route_change_begin(RouteTable *table);
+void route_change_end(RouteTable *table);
+char route_table_stable(RouteTable *table, unsigned long *seq);
 
-void inorder(struct Route * root );
+void inorder(RouteTable *table);
 
-char init_routes(struct Route** head);
\ No newline at end of file
+char init_routes(RouteTable *table);
@@ -26,10 +26,10 @@ typedef struct {
 } SUBStruct;
 
 SUBStruct *init_sub();
-char create_sub(SUBStruct * sub, cJSON *content, char** response);
+char create_sub(SUBStruct * sub, cJSON *content, HTTPResponse *response);
 
 cJSON *sub_to_json(const SUBStruct *sub);
 
-char update_sub(struct Route* destination, cJSON *content, char** response);
+char update_sub(struct Route* destination, cJSON *content, HTTPResponse *response);
 
-char get_sub(struct Route* destination, char** response);
\ No newline at end of file
+char get_sub(struct Route* destination, HTTPResponse *response);
\ No newline at end of file
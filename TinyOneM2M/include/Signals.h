@@ -7,4 +7,4 @@
  * Copyright (c) 2023 IPLeiria
  */
 
-void sigint_handler(int sig);
\ No newline at end of file
+char init_signals(void);
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#define SLAB_PAGE_SIZE (64 * 1024)
+
+typedef struct SlabPage {
+    struct SlabPage *next;
+} SlabPage;
+
+// Fixed size objects carved out of big pages. Freed objects are reused before
+// the newest page is touched again, pages go back only with free_slab.
+typedef struct Slab {
+    size_t object_size;
+    SlabPage *pages;
+    void *free_list; // freed objects, linked through their first word
+    char *next_object; // unused part of the newest page
+    char *page_end;
+    size_t in_use;
+    pthread_mutex_t lock;
+} Slab;
+
+#define SLAB_INITIALIZER(size) { (size), NULL, NULL, NULL, NULL, 0, PTHREAD_MUTEX_INITIALIZER }
+
+void *slab_alloc(Slab *slab);
+void slab_free(Slab *slab, void *object);
+void free_slab(Slab *slab);
+
+#endif
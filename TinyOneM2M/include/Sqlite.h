@@ -10,6 +10,42 @@
 #include <stdio.h>
 #include <sqlite3.h>
 
+// Page cache of each thread's connection
+#define DB_CACHE_SIZE_KB 8192
+
+// Statements every worker keeps prepared on its connection, see prepare_statement
+typedef enum {
+    STMT_INSERT_AE,
+    STMT_INSERT_CNT,
+    STMT_INSERT_CIN,
+    STMT_INSERT_SUB,
+    STMT_SELECT_BLOB_BY_URL,
+    STMT_SELECT_BLOB_BY_RI,
+    STMT_SELECT_BLOB_BY_RI_TY,
+    STMT_SELECT_LATEST_CIN,
+    STMT_SELECT_OLDEST_CIN,
+    STMT_SELECT_SUBSCRIBERS,
+    STMT_SELECT_AE,
+    STMT_SELECT_CNT,
+    STMT_SELECT_SUB,
+    STMT_SELECT_AE_TIMES,
+    STMT_SELECT_TIMES,
+    STMT_SELECT_CNT_ST,
+    STMT_SELECT_CNT_BLOB,
+    STMT_ADD_CNT_INSTANCE,
+    STMT_REMOVE_CNT_INSTANCES,
+    STMT_REMOVE_CNT_INSTANCE_BY_URL,
+    STMT_SELECT_EVICTION_CUTOFF,
+    STMT_SELECT_EVICTION_CUTOFF_BYTES,
+    STMT_DELETE_EVICTED_BODIES,
+    STMT_DELETE_EVICTED,
+    STMT_DELETE_BY_RI,
+    STMT_SELECT_ROUTE_CIN,
+    STMT_SELECT_URL_KEY_BY_RI,
+    STMT_SELECT_EXPIRED,
+    NUM_STATEMENTS
+} StatementId;
+
 int callback(void *NotUsed, int argc, char **argv, char **azColName);
 
 sqlite3 *initDatabase(const char* databasename);
@@ -17,6 +53,14 @@ sqlite3 *initDatabase(const char* databasename);
 short execDatabaseScript(char* query, struct sqlite3 *db, short isCallback);
 
 int closeDatabase(sqlite3 *db);
+void release_thread_database(void);
+
+sqlite3_stmt *prepare_statement(sqlite3 *db, StatementId id);
+void release_statement(sqlite3_stmt *stmt);
+
+char create_schema(sqlite3 *db);
+char upgrade_database(sqlite3 *db);
+char check_query_plans(sqlite3 *db);
 
 int begin_transaction(sqlite3 *db);
 int commit_transaction(sqlite3 *db);
@@ -0,0 +1,36 @@
+/*
+ * Created on Fri Oct 16 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef STATIC_CACHE_H
+#define STATIC_CACHE_H
+
+#include <stddef.h>
+
+#include "HTTP_Response.h"
+
+#define STATIC_TEMPLATES_DIR "templates"
+#define STATIC_ASSETS_DIR "static"
+#define STATIC_ASSETS_PREFIX "/static/"
+
+// A file loaded at startup. Templates are looked up by file name (the value of
+// their route), assets under static/ by their lowercased, percent-encoded URL.
+typedef struct {
+    char *key;
+    char *data;
+    size_t length;
+    const char *content_type;
+    char etag[32];
+} StaticAsset;
+
+char init_static_cache(void);
+void free_static_cache(void);
+const StaticAsset *static_cache_find(const char *key);
+void serve_static_asset(const StaticAsset *asset, const char *if_none_match, HTTPResponse *response);
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <time.h>
+
+// One slot per second. Deadlines further away than a full turn stay in their
+// slot and are skipped until the wheel comes around to them again.
+#define TIMER_WHEEL_SLOTS 64
+
+// Embedded in whatever needs a deadline, so adding and removing never allocates
+typedef struct TimerNode {
+    time_t deadline;
+    int slot; // -1 while not on the wheel
+    struct TimerNode *prev;
+    struct TimerNode *next;
+} TimerNode;
+
+typedef void (*timer_fn)(TimerNode *node, void *arg);
+
+typedef struct TimerWheel {
+    TimerNode *slots[TIMER_WHEEL_SLOTS];
+    time_t last_tick; // every slot up to this second was already expired
+} TimerWheel;
+
+void init_timer_wheel(TimerWheel *wheel, time_t now);
+void timer_node_init(TimerNode *node);
+void timer_wheel_add(TimerWheel *wheel, TimerNode *node, time_t deadline);
+void timer_wheel_remove(TimerWheel *wheel, TimerNode *node);
+int timer_wheel_expire(TimerWheel *wheel, time_t now, timer_fn expired, void *arg);
+
+#endif
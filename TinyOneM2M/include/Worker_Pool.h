@@ -0,0 +1,44 @@
+/*
+ * Created on Mon Oct 12 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+typedef void (*task_fn)(void *arg);
+
+typedef struct {
+    task_fn fn;
+    void *arg;
+} Task;
+
+// Fixed set of worker threads fed from a bounded ring of tasks
+typedef struct WorkerPool {
+    pthread_t *threads;
+    int num_threads;
+
+    Task *queue;
+    size_t capacity;
+    size_t head; // next task to run
+    size_t count; // tasks waiting in the queue
+
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    char stopping;
+} WorkerPool;
+
+char init_worker_pool(WorkerPool *pool, int num_threads, size_t queue_capacity);
+char worker_pool_submit(WorkerPool *pool, task_fn fn, void *arg);
+char worker_pool_try_submit(WorkerPool *pool, task_fn fn, void *arg);
+void destroy_worker_pool(WorkerPool *pool);
+
+#endif
@@ -41,7 +41,7 @@ AEStruct *init_ae() {
     return ae;
 }
 
-char create_ae(AEStruct *ae, cJSON *content, char **response) {
+char create_ae(AEStruct *ae, cJSON *content, HTTPResponse *response) {
     // Sqlite3 initialization opening/creating database
     struct sqlite3 *db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
@@ -51,38 +51,17 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
 
     // Convert the JSON object to a C structure
     // the URL attribute was already populated in the caller of this function
-    sqlite3_stmt *stmt;
+    sqlite3_stmt *stmt = NULL;
     int result;
-    const char *query = "SELECT COALESCE(MAX(CAST(substr(ri, 4) AS INTEGER)), 0) + 1 as result FROM mtc WHERE ty = 2";
 
-    // Prepare the SQL statement
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
-        fprintf(stderr, "Cannot prepare statement: %s\n", sqlite3_errmsg(db));
-        closeDatabase(db);
-        return FALSE;
-    }
-
-    char *ri = NULL;
-    // Execute the query and fetch the result
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        result = sqlite3_column_int(stmt, 0);
-        size_t ri_size = snprintf(NULL, 0, "CAE%d", result) + 1; // Get the required size for the ri string
-
-        ri = malloc(ri_size * sizeof(char)); // Allocate dynamic memory for the ri string
-        if (ri == NULL) {
-            fprintf(stderr, "Failed to allocate memory for ri\n");
-            sqlite3_finalize(stmt);
-            closeDatabase(db);
-            return FALSE;
-        }
-        snprintf(ri, ri_size, "CAE%d", result); // Write the formatted string to ri
-        cJSON_AddStringToObject(content, "ri", ri);
-    } else {
-        fprintf(stderr, "Failed to fetch the result\n");
-        sqlite3_finalize(stmt);
+    char *ri = malloc(sizeof(ae->ri));
+    if (ri == NULL || allocate_id(db, AE, ri, sizeof(ae->ri)) == FALSE) {
+        fprintf(stderr, "Failed to allocate the resource id\n");
+        free(ri);
         closeDatabase(db);
         return FALSE;
     }
+    cJSON_AddStringToObject(content, "ri", ri);
 
     ae->ty = AE;
     strcpy(ae->ri, cJSON_GetObjectItemCaseSensitive(content, "ri")->valuestring);
@@ -94,13 +73,13 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
 
     cJSON *et = cJSON_GetObjectItemCaseSensitive(content, "et");
     if (et) {
-        struct tm et_tm;
+        struct tm et_tm = {0};
         char *parse_result = strptime(et->valuestring, "%Y%m%dT%H%M%S", &et_tm);
         if (parse_result == NULL) {
             // The date string did not match the expected format
             responseMessage(response, 400, "Bad Request", "Invalid date format");
             free(ri); // Free allocated memory
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             return FALSE;
         }
@@ -108,6 +87,7 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
         time_t datetime_timestamp, current_time;
 
         // Convert the parsed time to a timestamp
+        et_tm.tm_isdst = -1; // mktime works out daylight saving time itself
         datetime_timestamp = mktime(&et_tm);
         // Get the current time
         current_time = time(NULL);
@@ -116,7 +96,7 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
         if (difftime(datetime_timestamp, current_time) < 0) {
             responseMessage(response, 400, "Bad Request", "Expiration time is in the past");
             free(ri); // Free allocated memory
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             return FALSE;
         }
@@ -152,7 +132,7 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
                     ae->json_poa = (char *)malloc(len + 1);
                     strcpy(ae->json_poa, json_str);
                 }
-                free(json_str); // Free the JSON string after copying
+                cJSON_free(json_str); // Free the JSON string after copying
             }
         } else {
             cJSON *empty_array = cJSON_CreateArray();
@@ -175,7 +155,7 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
                 strcpy(ae->json_poa, empty_array_str);
             }
             cJSON_Delete(empty_array);
-            free(empty_array_str);
+            cJSON_free(empty_array_str);
         }
     }
 
@@ -188,7 +168,7 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
         fprintf(stderr, "Memory allocation error\n");
         free(ri); // Free allocated memory
         cJSON_free(ae_json_str);
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
@@ -199,19 +179,16 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Can't begin transaction\n");
         free(ri); // Free allocated memory
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
 
     // Prepare the insert statement
-    const char *insertSQL = "INSERT INTO mtc (ty, ri, rn, pi, aei, api, rr, et, ct, lt, url, blob, acpi, lbl, daci, poa) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
-    rc = sqlite3_prepare_v2(db, insertSQL, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_INSERT_AE);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Verify the request body");
         free(ri); // Free allocated memory
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
@@ -250,7 +227,7 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
         fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
         responseMessage(response, 400, "Bad Request", "Verify the request body");
         rollback_transaction(db); // Rollback transaction
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         free(ri); // Free allocated memory
         closeDatabase(db);
         return FALSE;
@@ -260,31 +237,23 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
     rc = commit_transaction(db);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Can't commit transaction\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         free(ri); // Free allocated memory
         closeDatabase(db);
         return FALSE;
     }
 
     // Finalize the statement and close the database
-    sqlite3_finalize(stmt);
+    release_statement(stmt);
     free(ri); // Free allocated memory
 
-    char *sql_not = sqlite3_mprintf("SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');", ae->pi);
-    if (sql_not == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        return FALSE;
-    }
-
-    rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
-        sqlite3_free(sql_not);
+        closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, ae->pi, -1, SQLITE_STATIC);
 
     // Populate the CNT
     pthread_t thread_id;
@@ -384,8 +353,7 @@ char create_ae(AEStruct *ae, cJSON *content, char **response) {
         }
     }
 
-    sqlite3_finalize(stmt);
-    sqlite3_free(sql_not);
+    release_statement(stmt);
     closeDatabase(db);
 
     printf("AE data inserted successfully.\n");
@@ -443,30 +411,24 @@ cJSON *ae_to_json(const AEStruct *ae) {
     return root;
 }
 
-char update_ae(struct Route* destination, cJSON *content, char** response){
+char update_ae(struct Route* destination, cJSON *content, HTTPResponse *response){
     // retrieve the AE from tge database
-    char *sql = sqlite3_mprintf("SELECT ty, ri, rn, pi, aei, api, rr, et, ct, lt, acpi, lbl, daci, poa FROM mtc WHERE ri = '%s' AND ty = %d AND et > datetime('now');", destination->ri, destination->ty);
-    if (sql == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        return FALSE;
-    }
     sqlite3_stmt *stmt;
     struct sqlite3 * db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
         fprintf(stderr, "Failed to initialize the database.\n");
         responseMessage(response, 500, "Internal Server Error", "Failed to initialize the database.");
-        sqlite3_free(sql);
         return FALSE;
     }
-    short rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_AE);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, destination->ri, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, destination->ty);
+    short rc;
 
     // Populate the AE
     AEStruct *ae = init_ae();
@@ -509,6 +471,7 @@ char update_ae(struct Route* destination, cJSON *content, char** response){
         strcpy(ae->json_poa, (char *)sqlite3_column_text(stmt, 13));
         break;
     }
+    release_statement(stmt);
 
     // Update the MTC table
     char *updateQueryMTC = sqlite3_mprintf("UPDATE mtc SET "); //string to create query
@@ -560,7 +523,7 @@ char update_ae(struct Route* destination, cJSON *content, char** response){
             strcpy(ae->csz, json_strITEM);
         }else if (strcmp(key, "acpi") != 0 && strcmp(key, "lbl") != 0 && strcmp(key, "daci") != 0 && strcmp(key, "poa") != 0 && strcmp(key, "ch") != 0 && strcmp(key, "at") != 0){
             responseMessage(response, 400, "Bad Request", "Invalid key");
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             free(ae);
             return FALSE;
@@ -596,7 +559,7 @@ char update_ae(struct Route* destination, cJSON *content, char** response){
 
         // Add the expiration time into the update statement
         if(strcmp(key, "et") == 0) {
-            struct tm et_tm;
+            struct tm et_tm = {0};
             char *new_json_stringET = strdup(json_strITEM); // create a copy of json_strITEM
 
             // remove the last character from new_json_stringET
@@ -608,13 +571,14 @@ char update_ae(struct Route* destination, cJSON *content, char** response){
             if (parse_result == NULL) {
                 // The date string did not match the expected format
                 responseMessage(response, 400, "Bad Request", "Invalid date format");
-                sqlite3_finalize(stmt);
+                release_statement(stmt);
                 closeDatabase(db);
                 free(ae);
                 return FALSE;
             }
 
             // Convert the parsed time to a timestamp
+            et_tm.tm_isdst = -1; // mktime works out daylight saving time itself
             datetime_timestamp = mktime(&et_tm);
             // Get the current time
             current_time = time(NULL);
@@ -622,7 +586,7 @@ char update_ae(struct Route* destination, cJSON *content, char** response){
             // Compara o timestamp atual com o timestamp recebido, caso o timestamp está no passado dá excepção
             if (difftime(datetime_timestamp, current_time) < 0) {
                 responseMessage(response, 400, "Bad Request", "Expiration time is in the past");
-                sqlite3_finalize(stmt);
+                release_statement(stmt);
                 closeDatabase(db);
                 free(ae);
                 return FALSE;
@@ -640,19 +604,18 @@ char update_ae(struct Route* destination, cJSON *content, char** response){
     strcpy(ae->lt,getCurrentTime());
 
     //blob
-    size_t rnLengthBlob = strlen(cJSON_Print(ae_to_json(ae)));
-    ae->blob = (char *)malloc(rnLengthBlob);
+    // Printed once, the update stores the same text
+    ae->blob = cJSON_Print(ae_to_json(ae));
     if (ae->blob == NULL) {
         // Handle memory allocation error
         fprintf(stderr, "Memory allocation error\n");
         free(ae);
         return FALSE;
     }
-    strcpy(ae->blob, cJSON_Print(ae_to_json(ae)));  
     // Se tiver o valor inical não é feito o update
     if(strcmp(updateQueryMTC, "UPDATE mtc SET ") != 0){
 
-        updateQueryMTC = sqlite3_mprintf("%slt = %Q, blob = \'%s\' WHERE ri = %Q AND ty = %d", updateQueryMTC, getCurrentTimeLong(), ae->blob,destination->ri, destination->ty);
+        updateQueryMTC = sqlite3_mprintf("%slt = %Q, blob = %Q WHERE ri = %Q AND ty = %d", updateQueryMTC, getCurrentTimeLong(), ae->blob,destination->ri, destination->ty);
 
         rc = sqlite3_exec(db, updateQueryMTC, NULL, NULL, &errMsg);
         if (rc != SQLITE_OK) {
@@ -675,20 +638,15 @@ char update_ae(struct Route* destination, cJSON *content, char** response){
         }
         
         // Retrieve the AE with the updated expiration time
-        sql = sqlite3_mprintf("SELECT rr, et, lt FROM mtc WHERE ri = '%s' AND ty = %d AND et > datetime('now');", destination->ri, destination->ty);
-        printf("%s\n", sql);
-
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            rollback_transaction(db);
-            printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        stmt = prepare_statement(db, STMT_SELECT_AE_TIMES);
+        if (stmt == NULL) {
             responseMessage(response,400,"Bad Request","Failed to prepare statement.");
-            sqlite3_finalize(stmt);
-            sqlite3_free(errMsg);
             closeDatabase(db);
             free(ae);
             return FALSE;
         }
+        sqlite3_bind_text(stmt, 1, destination->ri, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, destination->ty);
 
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             strncpy(ae->rr, (char *)sqlite3_column_text(stmt, 0), 5);
@@ -709,50 +667,26 @@ char update_ae(struct Route* destination, cJSON *content, char** response){
     char *json_str = cJSON_Print(ae_to_json(ae));
     if (json_str == NULL) {
         fprintf(stderr, "Failed to print JSON as a string.\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         free(ae);
         return FALSE;
     }
     char * response_data = json_str;
     
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(response_data) + 1;
-    
-    // Allocate memory for the response buffer
-    *response = (char *)malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        sqlite3_finalize(stmt);
-        closeDatabase(db);
-        free(json_str);
-        free(ae);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", response_data);
+    // The printed JSON becomes the body, the response frees it once sent
+    http_response_json(response, 200, "OK", response_data, cJSON_free);
 
-    free(json_str);
-    sqlite3_finalize(stmt);
+    release_statement(stmt);
 
-    char *sql_not = sqlite3_mprintf("SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');", ae->pi);
-    if (sql_not == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        free(ae);
-        return FALSE;
-    }
-    rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         free(ae);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, ae->pi, -1, SQLITE_STATIC);
 
     // Populate the CNT
     pthread_t thread_id;
@@ -834,78 +768,50 @@ char update_ae(struct Route* destination, cJSON *content, char** response){
     return TRUE;
 }
 
-char get_ae(struct Route* destination, char** response){
-    char *sql = sqlite3_mprintf("SELECT blob, pi FROM mtc WHERE LOWER(url) = LOWER('%s') AND et > datetime('now');", destination->key);
-
-    if (sql == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        return FALSE;
-    }
+char get_ae(struct Route* destination, HTTPResponse *response){
     sqlite3_stmt *stmt;
     struct sqlite3 * db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
         fprintf(stderr, "Failed to initialize the database.\n");
-        sqlite3_free(sql);
         return FALSE;
     }
-    short rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
+    stmt = prepare_statement(db, STMT_SELECT_BLOB_BY_URL);
+    if (stmt == NULL) {
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, destination->key, -1, SQLITE_STATIC);
+    short rc;
     
     char *response_data = NULL;
     char *blob = NULL;
     char *pi = NULL;
     if ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         response_data = (char *)sqlite3_column_text(stmt, 0); // note the change in index to 0
-        blob = malloc(strlen(response_data));
+        blob = malloc(strlen(response_data) + 1);
         strcpy(blob, response_data);
-        pi = malloc(strlen((char *)sqlite3_column_text(stmt, 1)));
+        pi = malloc(strlen((char *)sqlite3_column_text(stmt, 1)) + 1);
         strcpy(pi, (char *)sqlite3_column_text(stmt, 1));
     } else {
         fprintf(stderr, "Failed to print JSON as a string.\n");
         responseMessage(response, 400, "Bad Request", "Failed to print JSON as a string.\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
 
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(response_data) + 1;
-    
-    // Allocate memory for the response buffer
-    *response = (char *)malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        sqlite3_finalize(stmt);
-        closeDatabase(db);
-        free(response_data);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", response_data);
-    sqlite3_finalize(stmt);
+    // The blob copy becomes the body, the response frees it once sent
+    http_response_json(response, 200, "OK", blob, free);
+    release_statement(stmt);
 
     if (blob != NULL) {
-        char *sql_not = sqlite3_mprintf("SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');", pi);
-        if (sql_not == NULL) {
-            fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-            responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-            return FALSE;
-        }
-        rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+        if (stmt == NULL) {
             responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-            sqlite3_finalize(stmt);
             closeDatabase(db);
             return FALSE;
         }
+        sqlite3_bind_text(stmt, 1, pi, -1, SQLITE_STATIC);
         
         // Populate the CNT
         pthread_t thread_id;
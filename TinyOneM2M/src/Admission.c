@@ -0,0 +1,102 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+
+#include "Common.h"
+
+extern int MAX_CONNECTIONS;
+extern int MAX_INFLIGHT;
+extern int RETRY_AFTER;
+
+static atomic_long open_connections = 0;
+static atomic_long inflight_requests = 0; // queued for a worker or running on one
+static atomic_long queued_requests = 0;
+static atomic_long shed_connections = 0;
+static atomic_long shed_requests = 0;
+
+// Always counts the connection, the caller reports it closed even when it is rejected
+char admission_connection_open(void) {
+    long open = atomic_fetch_add(&open_connections, 1) + 1;
+    if (MAX_CONNECTIONS > 0 && open > MAX_CONNECTIONS) {
+        atomic_fetch_add(&shed_connections, 1);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void admission_connection_closed(void) {
+    atomic_fetch_sub(&open_connections, 1);
+}
+
+// Reserves a slot for a readable connection before it is handed to the pool
+char admission_request_begin(void) {
+    long inflight = atomic_fetch_add(&inflight_requests, 1) + 1;
+    if (MAX_INFLIGHT > 0 && inflight > MAX_INFLIGHT) {
+        atomic_fetch_sub(&inflight_requests, 1);
+        atomic_fetch_add(&shed_requests, 1);
+        return FALSE;
+    }
+    atomic_fetch_add(&queued_requests, 1);
+    return TRUE;
+}
+
+// A worker picked the connection up
+void admission_request_started(void) {
+    atomic_fetch_sub(&queued_requests, 1);
+}
+
+void admission_request_end(void) {
+    atomic_fetch_sub(&inflight_requests, 1);
+}
+
+// Best effort 503 on a non-blocking socket. Whatever the client already sent is
+// read first, closing with unread data would reset the connection before the
+// client sees the answer. The caller still closes the socket.
+void admission_reject(int socket_desc) {
+    char discard[4096];
+    for (int i = 0; i < 16 && recv(socket_desc, discard, sizeof(discard), MSG_DONTWAIT) > 0; i++);
+
+    char message[160];
+    int length = snprintf(message, sizeof(message),
+        "HTTP/1.1 503 Service Unavailable\r\nRetry-After: %d\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+        RETRY_AFTER);
+    if (length > 0 && send(socket_desc, message, length, MSG_DONTWAIT | MSG_NOSIGNAL) == length) {
+        shutdown(socket_desc, SHUT_WR);
+    }
+}
+
+void admission_status(HTTPResponse *response) {
+    cJSON *status = cJSON_CreateObject();
+    if (status == NULL) {
+        responseMessage(response, 500, "Internal Server Error", "Could not create the status");
+        return;
+    }
+    cJSON_AddNumberToObject(status, "openConnections", atomic_load(&open_connections));
+    cJSON_AddNumberToObject(status, "maxConnections", MAX_CONNECTIONS);
+    cJSON_AddNumberToObject(status, "inflightRequests", atomic_load(&inflight_requests));
+    cJSON_AddNumberToObject(status, "queuedRequests", atomic_load(&queued_requests));
+    cJSON_AddNumberToObject(status, "maxInflight", MAX_INFLIGHT);
+    cJSON_AddNumberToObject(status, "shedConnections", atomic_load(&shed_connections));
+    cJSON_AddNumberToObject(status, "shedRequests", atomic_load(&shed_requests));
+
+    char *json = cJSON_PrintUnformatted(status);
+    cJSON_Delete(status);
+    if (json == NULL) {
+        responseMessage(response, 500, "Internal Server Error", "Could not create the status");
+        return;
+    }
+    http_response_json(response, 200, "OK", json, cJSON_free);
+    // Counters change with every request
+    http_response_header(response, "Cache-Control", "no-store");
+}
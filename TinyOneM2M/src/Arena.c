@@ -0,0 +1,117 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "Common.h"
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_ALIGN(n) (((n) + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1))
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(ArenaBlock))
+
+// Every thread that serves requests has its own arena, no locking needed
+static __thread Arena thread_arena;
+
+static ArenaBlock *new_block(size_t size) {
+    ArenaBlock *block = malloc(ARENA_HEADER_SIZE + size);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+static char arena_owns(const Arena *arena, const void *ptr) {
+    for (ArenaBlock *block = arena->blocks; block != NULL; block = block->next) {
+        const char *start = (const char *) block + ARENA_HEADER_SIZE;
+        if ((const char *) ptr >= start && (const char *) ptr < start + block->size) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// Outside a request (startup, notification threads) allocations are plain mallocs
+void *arena_alloc(size_t size) {
+    Arena *arena = &thread_arena;
+    if (!arena->active) {
+        return malloc(size);
+    }
+
+    size = ARENA_ALIGN(size > 0 ? size : 1);
+    ArenaBlock *block = arena->blocks;
+    if (block == NULL || block->size - block->used < size) {
+        // Big allocations get a block of their own, the rest share a fresh one
+        block = new_block(size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE);
+        if (block == NULL) {
+            return NULL;
+        }
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+
+    void *ptr = (char *) block + ARENA_HEADER_SIZE + block->used;
+    block->used += size;
+    return ptr;
+}
+
+char *arena_strdup(const char *s) {
+    size_t length = strlen(s) + 1;
+    char *copy = arena_alloc(length);
+    if (copy != NULL) {
+        memcpy(copy, s, length);
+    }
+    return copy;
+}
+
+// Memory from the arena goes away with arena_end, only what cJSON got from malloc is freed
+static void arena_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (thread_arena.active && arena_owns(&thread_arena, ptr)) {
+        return;
+    }
+    free(ptr);
+}
+
+void init_arena_hooks(void) {
+    cJSON_Hooks hooks = { .malloc_fn = arena_alloc, .free_fn = arena_free };
+    cJSON_InitHooks(&hooks);
+}
+
+void arena_begin(void) {
+    thread_arena.active = TRUE;
+}
+
+// Called once the response went out and its slices were released. One regular
+// block is kept for the next request, the others go back to malloc.
+void arena_end(void) {
+    Arena *arena = &thread_arena;
+    ArenaBlock *kept = NULL;
+    ArenaBlock *block = arena->blocks;
+    while (block != NULL) {
+        ArenaBlock *next = block->next;
+        if (kept == NULL && block->size == ARENA_BLOCK_SIZE) {
+            kept = block;
+            kept->next = NULL;
+            kept->used = 0;
+        } else {
+            free(block);
+        }
+        block = next;
+    }
+    arena->blocks = kept;
+    arena->active = FALSE;
+}
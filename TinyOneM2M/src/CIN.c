@@ -11,8 +11,9 @@
 
 extern int DAYS_PLUS_ET;
 
+// The CIN and its strings live in the request arena, none of them is freed by hand
 CINStruct *init_cin() {
-    CINStruct *cin = (CINStruct *) malloc(sizeof(CINStruct));
+    CINStruct *cin = (CINStruct *) arena_alloc(sizeof(CINStruct));
     if (cin) {
         cin->url = NULL;
         cin->ct[0] = '\0';
@@ -38,37 +39,17 @@ CINStruct *init_cin() {
     return cin;
 }
 
-char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
+char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, HTTPResponse *response) {
     // Convert the JSON object to a C structure
-    sqlite3_stmt *stmt;
-    int result;
-    const char *query =
-            "SELECT COALESCE(MAX(CAST(substr(ri, 5) AS INTEGER)), 0) + 1 as result FROM mtc WHERE ty = 4 AND et > datetime('now')";
-
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
-        fprintf(stderr, "Cannot prepare statement: %s\n", sqlite3_errmsg(db));
-        closeDatabase(db);
-        return FALSE;
-    }
-
-    char *ri = NULL;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        result = sqlite3_column_int(stmt, 0);
-        size_t ri_size = snprintf(NULL, 0, "CCIN%d", result) + 1;
+    sqlite3_stmt *stmt = NULL;
 
-        ri = malloc(ri_size * sizeof(char));
-        if (ri == NULL) {
-            fprintf(stderr, "Failed to allocate memory for ri\n");
-            closeDatabase(db);
-            return FALSE;
-        }
-        snprintf(ri, ri_size, "CCIN%d", result);
-        cJSON_AddStringToObject(content, "ri", ri);
-    } else {
-        fprintf(stderr, "Failed to fetch the result\n");
+    char *ri = arena_alloc(sizeof(cin->ri));
+    if (ri == NULL || allocate_id(db, CIN, ri, sizeof(cin->ri)) == FALSE) {
+        fprintf(stderr, "Failed to allocate the resource id\n");
         closeDatabase(db);
         return FALSE;
     }
+    cJSON_AddStringToObject(content, "ri", ri);
 
     cin->ty = CIN;
     strcpy(cin->ri, cJSON_GetObjectItemCaseSensitive(content, "ri")->valuestring);
@@ -77,7 +58,7 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
     cin->st = cJSON_GetObjectItemCaseSensitive(content, "st")->valueint;
 
     size_t rnLengthCon = strlen(cJSON_GetObjectItemCaseSensitive(content, "con")->valuestring) + 1;
-    cin->con = (char *) malloc(rnLengthCon);
+    cin->con = (char *) arena_alloc(rnLengthCon);
     if (cin->con == NULL) {
         fprintf(stderr, "Memory allocation error\n");
         responseMessage(response, 500, "Internal Server Error", "Memory allocation error.");
@@ -89,7 +70,7 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
 
     cJSON *et = cJSON_GetObjectItemCaseSensitive(content, "et");
     if (et) {
-        struct tm et_tm;
+        struct tm et_tm = {0};
         char *parse_result = strptime(et->valuestring, "%Y%m%dT%H%M%S", &et_tm);
         if (parse_result == NULL) {
             responseMessage(response, 400, "Bad Request", "Invalid date format");
@@ -97,14 +78,14 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
         }
 
         time_t datetime_timestamp, current_time;
+        et_tm.tm_isdst = -1; // mktime works out daylight saving time itself
         datetime_timestamp = mktime(&et_tm);
         current_time = time(NULL);
 
         if (difftime(datetime_timestamp, current_time) < 0) {
             responseMessage(response, 400, "Bad Request", "Expiration time is in the past");
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
-            free(cin);
             return FALSE;
         }
         strcpy(cin->et, et->valuestring);
@@ -123,10 +104,10 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
             if (json_str) {
                 size_t len = strlen(json_str) + 1;
                 if (strcmp(keys[i], "lbl") == 0) {
-                    cin->json_lbl = (char *) malloc(len);
+                    cin->json_lbl = (char *) arena_alloc(len);
                     strcpy(cin->json_lbl, json_str);
                 }
-                free(json_str);
+                cJSON_free(json_str);
             }
         } else if (json_array == NULL) {
             cJSON *empty_array = cJSON_CreateArray();
@@ -134,10 +115,10 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
             if (empty_str) {
                 size_t len = strlen(empty_str) + 1;
                 if (strcmp(keys[i], "lbl") == 0) {
-                    cin->json_lbl = (char *) malloc(len);
+                    cin->json_lbl = (char *) arena_alloc(len);
                     strcpy(cin->json_lbl, empty_str);
                 }
-                free(empty_str);
+                cJSON_free(empty_str);
             }
             cJSON_Delete(empty_array);
         }
@@ -147,22 +128,20 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
     char *json_string = cJSON_Print(content);
     if (json_string == NULL) {
         fprintf(stderr, "Failed to generate JSON string\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
-        free(cin);
         return FALSE;
     }
 
     size_t rnLengthBlob = strlen(json_string) + 1;
-    cin->blob = (char *) malloc(rnLengthBlob);
+    cin->blob = (char *) arena_alloc(rnLengthBlob);
     if (cin->blob == NULL) {
         fprintf(stderr, "Memory allocation error\n");
-        free(json_string);
-        free(cin);
+        cJSON_free(json_string);
         return FALSE;
     }
     strcpy(cin->blob, json_string);
-    free(json_string);
+    cJSON_free(json_string);
 
     short rc = begin_transaction(db);
     if (rc != SQLITE_OK) {
@@ -171,13 +150,8 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
         return FALSE;
     }
 
-    const char *insertSQL =
-            "INSERT INTO mtc (ty, ri, rn, pi, st, cnf, cs, con, et, ct, lt, url, blob, lbl) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
-
-    rc = sqlite3_prepare_v2(db, insertSQL, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
+    stmt = prepare_statement(db, STMT_INSERT_CIN);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Verify the request body");
         closeDatabase(db);
         return FALSE;
@@ -211,172 +185,53 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
         fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
         responseMessage(response, 400, "Bad Request", "Verify the request body");
         rollback_transaction(db);
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
 
-    sqlite3_finalize(stmt);
+    release_statement(stmt);
 
-    // Actions that need to done in the CNT resource update the cni and cbs
-    int cni, mni, cbs, mbs;
-    char *sql = sqlite3_mprintf("SELECT cni, mni, cbs, mbs, blob FROM mtc WHERE ri = '%s' AND et > datetime('now');",
-                                cin->pi);
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
-    sqlite3_free(sql);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
+    // Actions that need to done in the CNT resource update the cni and cbs.
+    // Only the counter columns change, the CNT blob gets them when it is read.
+    int cni = 0, mni = -1, cbs = 0, mbs = -1;
+    stmt = prepare_statement(db, STMT_ADD_CNT_INSTANCE);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Verify the request body");
         rollback_transaction(db);
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_int(stmt, 1, cin->cs);
+    sqlite3_bind_text(stmt, 2, cin->pi, -1, SQLITE_STATIC);
 
-    cJSON *cntBlob = NULL;
-    if ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-        cni = sqlite3_column_int(stmt, 0) + 1;
-        if (sqlite3_column_type(stmt, 1) == SQLITE_NULL) {
-            mni = -1;
-        } else {
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        cni = sqlite3_column_int(stmt, 0);
+        if (sqlite3_column_type(stmt, 1) != SQLITE_NULL) {
             mni = sqlite3_column_int(stmt, 1);
         }
-        cbs = sqlite3_column_int(stmt, 2) + cin->cs;
-        if (sqlite3_column_type(stmt, 3) == SQLITE_NULL) {
-            mbs = -1;
-        } else {
+        cbs = sqlite3_column_int(stmt, 2);
+        if (sqlite3_column_type(stmt, 3) != SQLITE_NULL) {
             mbs = sqlite3_column_int(stmt, 3);
         }
-
-        cntBlob = cJSON_Parse((char *) sqlite3_column_text(stmt, 4));
-        cJSON *cnt = cJSON_GetObjectItem(cntBlob, "m2m:cnt");
-        if (cnt != NULL) {
-            cJSON *JsonCni = cJSON_GetObjectItem(cnt, "cni");
-            cJSON *JsonCbs = cJSON_GetObjectItem(cnt, "cbs");
-
-            if (JsonCni != NULL) {
-                cJSON_ReplaceItemInObject(cnt, "cni", cJSON_CreateNumber(cni));
-            }
-
-            if (JsonCbs != NULL) {
-                cJSON_ReplaceItemInObject(cnt, "cbs", cJSON_CreateNumber(cbs));
-            }
-        }
-    }
-
-    sqlite3_finalize(stmt);
-
-    const char *updateSql = "UPDATE mtc SET cni = ?, cbs = ?, blob = ? WHERE ri = ?;";
-    rc = sqlite3_prepare_v2(db, updateSql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
+    } else if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
         responseMessage(response, 400, "Bad Request", "Verify the request body");
+        rollback_transaction(db);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    release_statement(stmt);
 
-    char *cntBlobString = cJSON_Print(cntBlob);
-    sqlite3_bind_int(stmt, 1, cni);
-    sqlite3_bind_int(stmt, 2, cbs);
-    sqlite3_bind_text(stmt, 3, cntBlobString, strlen(cntBlobString), SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, cin->pi, strlen(cin->pi), SQLITE_STATIC);
-
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE) {
-        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
+    if (evict_cin_instances(db, cin->pi, &cni, mni, &cbs, mbs) == FALSE) {
         responseMessage(response, 400, "Bad Request", "Verify the request body");
         rollback_transaction(db);
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
 
-    sqlite3_finalize(stmt);
-    free(cntBlobString);
-
-    while ((mni != -1 && cni > mni) || (mbs != -1 && cbs > mbs)) {
-        char instance_id[30];
-        int instance_size;
-        sql = sqlite3_mprintf("SELECT ri, cs FROM mtc WHERE pi = '%s' AND et > datetime('now') ORDER BY ct LIMIT 1;",
-                              cin->pi);
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
-        sqlite3_free(sql);
-        if (rc != SQLITE_OK) {
-            fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
-            responseMessage(response, 400, "Bad Request", "Verify the request body");
-            rollback_transaction(db);
-            sqlite3_finalize(stmt);
-            closeDatabase(db);
-            return FALSE;
-        }
-
-        if ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-            strcpy(instance_id, (char *) sqlite3_column_text(stmt, 0));
-            instance_size = sqlite3_column_int(stmt, 1);
-        }
-
-        sqlite3_finalize(stmt);
-
-        sql = sqlite3_mprintf("DELETE FROM mtc WHERE ri = '%s' AND et > datetime('now');", instance_id);
-        char *err_msg = NULL;
-        rc = sqlite3_exec(db, sql, 0, 0, &err_msg);
-        sqlite3_free(sql);
-        if (rc != SQLITE_OK) {
-            fprintf(stderr, "Failed to execute statement: %s\n", err_msg);
-            responseMessage(response, 400, "Bad Request", "Verify the request body");
-            rollback_transaction(db);
-            sqlite3_finalize(stmt);
-            closeDatabase(db);
-            return FALSE;
-        }
-
-        cni--;
-        cbs -= instance_size;
-
-        cJSON *cnt = cJSON_GetObjectItem(cntBlob, "m2m:cnt");
-        if (cnt != NULL) {
-            cJSON *JsonCni = cJSON_GetObjectItem(cnt, "cni");
-            cJSON *JsonCbs = cJSON_GetObjectItem(cnt, "cbs");
-
-            if (JsonCni != NULL) {
-                cJSON_ReplaceItemInObject(cnt, "cni", cJSON_CreateNumber(cni));
-            }
-
-            if (JsonCbs != NULL) {
-                cJSON_ReplaceItemInObject(cnt, "cbs", cJSON_CreateNumber(cbs));
-            }
-        }
-
-        rc = sqlite3_prepare_v2(db, updateSql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
-            sqlite3_finalize(stmt);
-            responseMessage(response, 400, "Bad Request", "Verify the request body");
-            closeDatabase(db);
-            return FALSE;
-        }
-
-        cntBlobString = cJSON_Print(cntBlob);
-        sqlite3_bind_int(stmt, 1, cni);
-        sqlite3_bind_int(stmt, 2, cbs);
-        sqlite3_bind_text(stmt, 3, cntBlobString, strlen(cntBlobString), SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 4, cin->pi, strlen(cin->pi), SQLITE_STATIC);
-
-        rc = sqlite3_step(stmt);
-        if (rc != SQLITE_DONE) {
-            fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
-            responseMessage(response, 400, "Bad Request", "Verify the request body");
-            rollback_transaction(db);
-            sqlite3_finalize(stmt);
-            closeDatabase(db);
-            return FALSE;
-        }
-
-        sqlite3_finalize(stmt);
-        free(cntBlobString);
-    }
-
     cJSON_Delete(content);
     rc = commit_transaction(db);
     if (rc != SQLITE_OK) {
@@ -386,22 +241,13 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
         return FALSE;
     }
 
-    char *sql_not = sqlite3_mprintf(
-        "SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');",
-        cin->pi);
-    if (sql_not == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        return FALSE;
-    }
-    rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, cin->pi, -1, SQLITE_STATIC);
 
     pthread_t thread_id;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
@@ -474,7 +320,7 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
         }
     }
 
-    sqlite3_finalize(stmt);
+    release_statement(stmt);
     if (db) {
         closeDatabase(db);
     }
@@ -482,6 +328,102 @@ char create_cin(sqlite3 *db, CINStruct *cin, cJSON *content, char **response) {
     return TRUE;
 }
 
+// Brings a container back within mni and mbs. The instances to drop are
+// always its oldest ones, found as a cutoff id and removed with one range
+// delete, and the counters are updated once for all of them. cni and cbs are
+// the container's current counters and come back with what is left.
+char evict_cin_instances(sqlite3 *db, const char *cnt_ri, int *cni, int mni, int *cbs, int mbs) {
+    int excess_instances = (mni != -1 && *cni > mni) ? *cni - mni : 0;
+    int excess_bytes = (mbs != -1 && *cbs > mbs) ? *cbs - mbs : 0;
+    if (excess_instances == 0 && excess_bytes == 0) {
+        return TRUE;
+    }
+
+    // Only mbs needs the sizes added up, mni alone is an offset in the index
+    sqlite3_stmt *stmt = prepare_statement(db, excess_bytes > 0 ? STMT_SELECT_EVICTION_CUTOFF_BYTES : STMT_SELECT_EVICTION_CUTOFF);
+    if (stmt == NULL) {
+        return FALSE;
+    }
+    sqlite3_bind_text(stmt, 1, cnt_ri, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, excess_instances);
+    if (excess_bytes > 0) {
+        sqlite3_bind_int(stmt, 3, excess_bytes);
+    }
+    sqlite3_int64 cutoff = -1;
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        cutoff = sqlite3_column_int64(stmt, 0);
+    }
+    release_statement(stmt);
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
+        return FALSE;
+    }
+    if (cutoff == -1) {
+        // The counters claim more than the container holds, there is nothing to drop
+        return TRUE;
+    }
+
+    // The bodies go first, their ids are read from the mtc_meta rows
+    stmt = prepare_statement(db, STMT_DELETE_EVICTED_BODIES);
+    if (stmt == NULL) {
+        return FALSE;
+    }
+    sqlite3_bind_text(stmt, 1, cnt_ri, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, cutoff);
+    rc = sqlite3_step(stmt);
+    release_statement(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
+        return FALSE;
+    }
+
+    stmt = prepare_statement(db, STMT_DELETE_EVICTED);
+    if (stmt == NULL) {
+        return FALSE;
+    }
+    sqlite3_bind_text(stmt, 1, cnt_ri, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, cutoff);
+    int removed = 0, removed_bytes = 0;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        removed++;
+        removed_bytes += sqlite3_column_int(stmt, 1);
+
+        // A cached route to an evicted instance would outlive it
+        const char *url = (const char *) sqlite3_column_text(stmt, 0);
+        if (url != NULL) {
+            char *key = arena_strdup(url);
+            if (key != NULL) {
+                to_lowercase(key);
+                route_cache_remove(key);
+            }
+        }
+    }
+    release_statement(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
+        return FALSE;
+    }
+
+    stmt = prepare_statement(db, STMT_REMOVE_CNT_INSTANCES);
+    if (stmt == NULL) {
+        return FALSE;
+    }
+    sqlite3_bind_int(stmt, 1, removed);
+    sqlite3_bind_int(stmt, 2, removed_bytes);
+    sqlite3_bind_text(stmt, 3, cnt_ri, -1, SQLITE_STATIC);
+    rc = sqlite3_step(stmt);
+    release_statement(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
+        return FALSE;
+    }
+
+    *cni -= removed;
+    *cbs -= removed_bytes;
+    return TRUE;
+}
+
 cJSON *cin_to_json(const CINStruct *cin) {
     cJSON *innerObject = cJSON_CreateObject();
     cJSON_AddStringToObject(innerObject, "ct", cin->ct);
@@ -524,40 +466,32 @@ cJSON *cin_to_json(const CINStruct *cin) {
     return root;
 }
 
-char get_cin(struct Route *destination, char **response) {
-    char *sql = NULL;
-    if ((destination->key + strlen(destination->key) - strlen("la")) == strstr(destination->key, "la") ||
-        (destination->key + strlen(destination->key) - strlen("ol")) == strstr(destination->key, "ol")) {
-        sql = sqlite3_mprintf(
-            "SELECT blob, pi FROM mtc WHERE LOWER(pi) = LOWER('%s') AND et > datetime('now') AND ty = %d ORDER BY ROWID %s LIMIT 1;",
-            destination->ri,
-            CIN,
-            ((destination->key + strlen(destination->key) - strlen("la")) == strstr(destination->key, "la"))
-                ? "DESC"
-                : "ASC");
-    } else {
-        sql = sqlite3_mprintf("SELECT blob, pi FROM mtc WHERE LOWER(url) = LOWER('%s') AND et > datetime('now');",
-                              destination->key);
-    }
+char get_cin(struct Route *destination, HTTPResponse *response) {
+    char latest = (destination->key + strlen(destination->key) - strlen("la")) == strstr(destination->key, "la");
+    char oldest = (destination->key + strlen(destination->key) - strlen("ol")) == strstr(destination->key, "ol");
 
-    if (sql == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        return FALSE;
-    }
     sqlite3_stmt *stmt;
     struct sqlite3 *db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
         fprintf(stderr, "Failed to initialize the database.\n");
-        sqlite3_free(sql);
         return FALSE;
     }
-    short rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
+    if (latest || oldest) {
+        stmt = prepare_statement(db, latest ? STMT_SELECT_LATEST_CIN : STMT_SELECT_OLDEST_CIN);
+        if (stmt != NULL) {
+            sqlite3_bind_text(stmt, 1, destination->ri, -1, SQLITE_STATIC);
+        }
+    } else {
+        stmt = prepare_statement(db, STMT_SELECT_BLOB_BY_URL);
+        if (stmt != NULL) {
+            sqlite3_bind_text(stmt, 1, destination->key, -1, SQLITE_STATIC);
+        }
+    }
+    if (stmt == NULL) {
         closeDatabase(db);
         return FALSE;
     }
+    short rc;
 
     // Copy the blob from the resource to the response_data
     char *response_data = NULL;
@@ -566,73 +500,47 @@ char get_cin(struct Route *destination, char **response) {
     rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         response_data = (char *) sqlite3_column_text(stmt, 0); // note the change in index to 0
-        blob = malloc(strlen(response_data) + 1);
+        blob = arena_strdup(response_data);
         if (blob == NULL) {
             fprintf(stderr, "Failed to allocate memory for blob.\n");
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             return FALSE;
         }
-        strcpy(blob, response_data);
 
-        pi = malloc(strlen((char *) sqlite3_column_text(stmt, 1)) + 1);
+        pi = arena_strdup((char *) sqlite3_column_text(stmt, 1));
         if (pi == NULL) {
             fprintf(stderr, "Failed to allocate memory for pi.\n");
-            free(blob);
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             return FALSE;
         }
-        strcpy(pi, (char *) sqlite3_column_text(stmt, 1));
-    } else if (rc == SQLITE_DONE && ((destination->key + strlen(destination->key) - strlen("la")) == strstr(
-                                         destination->key, "la") ||
-                                     (destination->key + strlen(destination->key) - strlen("ol")) == strstr(
-                                         destination->key, "ol"))) {
-        response_data = strdup("{\"m2m:dbg\": \"no instance for <latest> or <oldest>\"}");
+    } else if (rc == SQLITE_DONE && (latest || oldest)) {
+        response_data = "{\"m2m:dbg\": \"no instance for <latest> or <oldest>\"}";
     } else {
         fprintf(stderr, "Failed to print JSON as a string.\n");
         responseMessage(response, 400, "Bad Request", "Failed to print JSON as a string.\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
 
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(response_data) +
-                           1;
-
-    // Allocate memory for the response buffer
-    *response = (char *) malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        sqlite3_finalize(stmt);
-        closeDatabase(db);
-        free(response_data);
-        return FALSE;
+    if (blob != NULL) {
+        // The blob copy becomes the body, it lives in the request arena until the response is sent
+        http_response_json(response, 200, "OK", blob, NULL);
+    } else {
+        http_response_json(response, 200, "OK", response_data, NULL);
     }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", response_data);
-    sqlite3_finalize(stmt);
+    release_statement(stmt);
 
     if (blob != NULL) {
-        char *sql_not = sqlite3_mprintf(
-            "SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');",
-            pi);
-        if (sql_not == NULL) {
-            fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-            responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-            return FALSE;
-        }
-        rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+        if (stmt == NULL) {
             responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-            sqlite3_finalize(stmt);
             closeDatabase(db);
             return FALSE;
         }
+        sqlite3_bind_text(stmt, 1, pi, -1, SQLITE_STATIC);
 
         pthread_t thread_id;
         // Send notifications
@@ -41,7 +41,7 @@ CNTStruct *init_cnt() {
     return cnt;
 }
 
-char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
+char create_cnt(CNTStruct *cnt, cJSON *content, HTTPResponse *response) {
     // Sqlite3 initialization opening/creating database
     struct sqlite3 *db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
@@ -49,33 +49,15 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
         return FALSE;
     }
 
-    sqlite3_stmt *stmt;
-    int result;
-    const char *query = "SELECT COALESCE(MAX(CAST(substr(ri, 5) AS INTEGER)), 0) + 1 as result FROM mtc WHERE ty = 3";
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
-        fprintf(stderr, "Cannot prepare statement: %s\n", sqlite3_errmsg(db));
-        closeDatabase(db);
-        return FALSE;
-    }
-
-    char *ri = NULL;
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        result = sqlite3_column_int(stmt, 0);
-        size_t ri_size = snprintf(NULL, 0, "CCNT%d", result) + 1;
-
-        ri = malloc(ri_size * sizeof(char));
-        if (ri == NULL) {
-            fprintf(stderr, "Failed to allocate memory for ri\n");
-            closeDatabase(db);
-            return FALSE;
-        }
-        snprintf(ri, ri_size, "CCNT%d", result);
-        cJSON_AddStringToObject(content, "ri", ri);
-    } else {
-        fprintf(stderr, "Failed to fetch the result\n");
+    sqlite3_stmt *stmt = NULL;
+    char *ri = malloc(sizeof(cnt->ri));
+    if (ri == NULL || allocate_id(db, CNT, ri, sizeof(cnt->ri)) == FALSE) {
+        fprintf(stderr, "Failed to allocate the resource id\n");
+        free(ri);
         closeDatabase(db);
         return FALSE;
     }
+    cJSON_AddStringToObject(content, "ri", ri);
     cnt->ty = CNT;
     strcpy(cnt->ri, cJSON_GetObjectItemCaseSensitive(content, "ri")->valuestring);
     strcpy(cnt->rn, cJSON_GetObjectItemCaseSensitive(content, "rn")->valuestring);
@@ -85,7 +67,7 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
 
     cJSON *et = cJSON_GetObjectItemCaseSensitive(content, "et");
     if (et) {
-        struct tm et_tm;
+        struct tm et_tm = {0};
         char *parse_result = strptime(et->valuestring, "%Y%m%dT%H%M%S", &et_tm);
         if (parse_result == NULL) {
             responseMessage(response, 400, "Bad Request", "Invalid date format");
@@ -94,12 +76,14 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
 
         time_t datetime_timestamp, current_time;
 
+        et_tm.tm_isdst = -1; // mktime works out daylight saving time itself
+
         datetime_timestamp = mktime(&et_tm);
         current_time = time(NULL);
 
         if (difftime(datetime_timestamp, current_time) < 0) {
             responseMessage(response, 400, "Bad Request", "Expiration time is in the past");
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             free(cnt);
             return FALSE;
@@ -129,7 +113,7 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
                     cnt->json_daci = (char *)malloc(len);
                     strcpy(cnt->json_daci, json_str);
                 }
-                free(json_str);
+                cJSON_free(json_str);
             }
         } else if (json_array == NULL) {
             cJSON *empty_array = cJSON_CreateArray();
@@ -146,7 +130,7 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
                     cnt->json_daci = (char *)malloc(len);
                     strcpy(cnt->json_daci, empty_str);
                 }
-                free(empty_str);
+                cJSON_free(empty_str);
             }
             cJSON_Delete(empty_array);
         }
@@ -156,7 +140,7 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
     char *json_string = cJSON_Print(content);
     if (json_string == NULL) {
         fprintf(stderr, "Failed to generate JSON string\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         free(cnt);
         return FALSE;
@@ -166,12 +150,12 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
     cnt->blob = (char *)malloc(rnLengthBlob);
     if (cnt->blob == NULL) {
         fprintf(stderr, "Memory allocation error\n");
-        free(json_string);
+        cJSON_free(json_string);
         free(cnt);
         return FALSE;
     }
     strcpy(cnt->blob, json_string);
-    free(json_string);
+    cJSON_free(json_string);
 
     short rc = begin_transaction(db);
     if (rc != SQLITE_OK) {
@@ -180,12 +164,8 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
         return FALSE;
     }
 
-    const char *insertSQL =
-            "INSERT INTO mtc (ty, ri, rn, pi, st, mni, mbs, cni, cbs, et, ct, lt, url, blob, acpi, lbl, daci) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
-
-    rc = sqlite3_prepare_v2(db, insertSQL, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_INSERT_CNT);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Verify the request body");
         closeDatabase(db);
         return FALSE;
@@ -224,7 +204,7 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
         fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
         responseMessage(response, 400, "Bad Request", "Verify the request body");
         rollback_transaction(db);
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
@@ -233,27 +213,18 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
     rc = commit_transaction(db);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Can't commit transaction\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
 
-    char *sql_not = sqlite3_mprintf(
-            "SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');",
-            cnt->pi);
-    if (sql_not == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        return FALSE;
-    }
-    rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, cnt->pi, -1, SQLITE_STATIC);
 
     pthread_t thread_id;
     // Trigger notification
@@ -327,12 +298,67 @@ char create_cnt(CNTStruct *cnt, cJSON *content, char **response) {
         }
     }
 
-    sqlite3_finalize(stmt);
+    release_statement(stmt);
     closeDatabase(db);
     printf("CNT data inserted successfully.\n");
     return TRUE;
 }
 
+// Points at the value of an attribute in a blob printed by cJSON. A quote
+// inside a string value is always escaped, so the key is the first match not
+// preceded by a backslash.
+static const char *find_blob_value(const char *blob, const char *key) {
+    char pattern[20];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *at = strstr(blob, pattern);
+    while (at != NULL && at != blob && at[-1] == '\\') {
+        at = strstr(at + 1, pattern);
+    }
+    if (at == NULL) {
+        return NULL;
+    }
+    at += strlen(pattern);
+    return at + strspn(at, " \t\r\n");
+}
+
+// The stored CNT blob is written with the counters it had at the time, the
+// columns hold the current ones. Returns a malloc'ed copy of the blob with
+// cni and cbs taken from the columns.
+char *render_cnt(const char *blob, int cni, int cbs) {
+    if (blob == NULL) {
+        return NULL;
+    }
+    char *rendered = malloc(strlen(blob) + 2 * 12 + 1);
+    if (rendered == NULL) {
+        return NULL;
+    }
+
+    // Spliced in the order they appear in the blob
+    const char *values[] = {find_blob_value(blob, "cni"), find_blob_value(blob, "cbs")};
+    int numbers[] = {cni, cbs};
+    if (values[0] != NULL && values[1] != NULL && values[1] < values[0]) {
+        const char *value = values[0];
+        values[0] = values[1];
+        values[1] = value;
+        numbers[0] = cbs;
+        numbers[1] = cni;
+    }
+
+    const char *from = blob;
+    char *to = rendered;
+    for (int i = 0; i < 2; i++) {
+        if (values[i] == NULL) {
+            continue;
+        }
+        memcpy(to, from, values[i] - from);
+        to += values[i] - from;
+        to += sprintf(to, "%d", numbers[i]);
+        from = values[i] + strcspn(values[i], ",}\r\n\t ");
+    }
+    strcpy(to, from);
+    return rendered;
+}
+
 cJSON *cnt_to_json(const CNTStruct *cnt) {
     cJSON *innerObject = cJSON_CreateObject();
     cJSON_AddStringToObject(innerObject, "ct", cnt->ct);
@@ -381,32 +407,23 @@ cJSON *cnt_to_json(const CNTStruct *cnt) {
     return root;
 }
 
-char update_cnt(struct Route *destination, cJSON *content, char **response) {
+char update_cnt(struct Route *destination, cJSON *content, HTTPResponse *response) {
     // retrieve the CNT from the database
-    char *sql = sqlite3_mprintf(
-        "SELECT ty, ri, rn, pi, st, mni, mbs, cni, cbs, et, ct, lt, acpi, lbl, daci FROM mtc WHERE LOWER(url) = LOWER('%s') AND et > datetime('now');",
-        destination->key);
-    if (sql == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        return FALSE;
-    }
     sqlite3_stmt *stmt;
     struct sqlite3 *db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
         fprintf(stderr, "Failed to initialize the database.\n");
         responseMessage(response, 500, "Internal Server Error", "Failed to initialize the database.");
-        sqlite3_free(sql);
         return FALSE;
     }
-    short rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_CNT);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, destination->key, -1, SQLITE_STATIC);
+    short rc;
 
     // Populate the CNT
     CNTStruct *cnt = init_cnt();
@@ -416,8 +433,9 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
         strncpy(cnt->rn, (char *) sqlite3_column_text(stmt, 2), 50);
         strncpy(cnt->pi, (char *) sqlite3_column_text(stmt, 3), 10);
         cnt->st = sqlite3_column_int(stmt, 4);
-        cnt->mni = sqlite3_column_int(stmt, 5);
-        cnt->mbs = sqlite3_column_int(stmt, 6);
+        // A container without limits has them NULL, not 0
+        cnt->mni = sqlite3_column_type(stmt, 5) == SQLITE_NULL ? -1 : sqlite3_column_int(stmt, 5);
+        cnt->mbs = sqlite3_column_type(stmt, 6) == SQLITE_NULL ? -1 : sqlite3_column_int(stmt, 6);
         cnt->cni = sqlite3_column_int(stmt, 7);
         cnt->cbs = sqlite3_column_int(stmt, 8);
         const char *et_iso = (const char *) sqlite3_column_text(stmt, 9);
@@ -436,6 +454,7 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
         strncpy(cnt->et, et_str, 20);
         break;
     }
+    release_statement(stmt);
 
     // Update the MTC table
     char *updateQueryMTC = sqlite3_mprintf("UPDATE mtc SET "); //string to create query
@@ -489,7 +508,7 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
         } else if (strcmp(key, "acpi") != 0 && strcmp(key, "lbl") != 0 && strcmp(key, "daci") != 0 && strcmp(key, "ch")
                    != 0 && strcmp(key, "at") != 0 && strcmp(key, "or") != 0 && strcmp(key, "dr") != 0) {
             responseMessage(response, 400, "Bad Request", "Invalid key");
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             free(cnt);
             return FALSE;
@@ -522,7 +541,7 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
 
         // Add the expiration time into the update statement
         if (strcmp(key, "et") == 0) {
-            struct tm et_tm;
+            struct tm et_tm = {0};
             char *new_json_stringET = strdup(json_strITEM); // create a copy of json_strITEM
 
             // remove the last character from new_json_stringET
@@ -534,13 +553,14 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
             if (parse_result == NULL) {
                 // The date string did not match the expected format
                 responseMessage(response, 400, "Bad Request", "Invalid date format");
-                sqlite3_finalize(stmt);
+                release_statement(stmt);
                 closeDatabase(db);
                 free(cnt);
                 return FALSE;
             }
 
             // Convert the parsed time to a timestamp
+            et_tm.tm_isdst = -1; // mktime works out daylight saving time itself
             datetime_timestamp = mktime(&et_tm);
             // Get the current time
             current_time = time(NULL);
@@ -548,7 +568,7 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
             // Compara o timestamp atual com o timestamp recebido, caso o timestamp está no passado dá excepção
             if (difftime(datetime_timestamp, current_time) < 0) {
                 responseMessage(response, 400, "Bad Request", "Expiration time is in the past");
-                sqlite3_finalize(stmt);
+                release_statement(stmt);
                 closeDatabase(db);
                 free(cnt);
                 return FALSE;
@@ -573,7 +593,7 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
         char *json_string = cJSON_Print(cnt_to_json(cnt));
         if (json_string == NULL) {
             fprintf(stderr, "Failed to generate JSON string\n");
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             free(cnt);
             return FALSE;
@@ -583,15 +603,15 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
         cnt->blob = (char *)malloc(rnLengthBlob);
         if (cnt->blob == NULL) {
             fprintf(stderr, "Memory allocation error\n");
-            free(json_string);
+            cJSON_free(json_string);
             free(cnt);
             return FALSE;
         }
 
         strcpy(cnt->blob, json_string);
-        free(json_string);  // Free the temporary JSON string
+        cJSON_free(json_string);  // Free the temporary JSON string
 
-        updateQueryMTC = sqlite3_mprintf("%slt = %Q, st = %d, blob = '%s' WHERE url = %Q",
+        updateQueryMTC = sqlite3_mprintf("%slt = %Q, st = %d, blob = %Q WHERE url = %Q",
                                          updateQueryMTC, cnt->lt, cnt->st, cnt->blob, destination->key);
 
         rc = sqlite3_exec(db, updateQueryMTC, NULL, NULL, &errMsg);
@@ -605,6 +625,18 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
             return FALSE;
         }
 
+        // Lowering mni or mbs drops the oldest instances right away
+        int cni = cnt->cni, cbs = cnt->cbs;
+        if (evict_cin_instances(db, cnt->ri, &cni, cnt->mni, &cbs, cnt->mbs) == FALSE) {
+            rollback_transaction(db);
+            responseMessage(response, 500, "Internal Server Error", "Could not remove the oldest instances.");
+            closeDatabase(db);
+            free(cnt);
+            return FALSE;
+        }
+        cnt->cni = cni;
+        cnt->cbs = cbs;
+
         rc = commit_transaction(db);
         if (rc != SQLITE_OK) {
             fprintf(stderr, "Can't commit transaction\n");
@@ -615,21 +647,15 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
         }
 
         // Retrieve the AE with the updated expiration time
-        sql = sqlite3_mprintf("SELECT et, lt FROM mtc WHERE ri = '%s' AND ty = %d AND et > datetime('now');",
-                              destination->ri, destination->ty);
-        printf("%s\n", sql);
-
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            rollback_transaction(db);
-            printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        stmt = prepare_statement(db, STMT_SELECT_TIMES);
+        if (stmt == NULL) {
             responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-            sqlite3_finalize(stmt);
-            sqlite3_free(errMsg);
             closeDatabase(db);
             free(cnt);
             return FALSE;
         }
+        sqlite3_bind_text(stmt, 1, destination->ri, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, destination->ty);
 
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             const char *et_iso = (const char *)sqlite3_column_text(stmt, 0);
@@ -650,53 +676,26 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
     char *json_str = cJSON_Print(cnt_to_json(cnt));
     if (json_str == NULL) {
         fprintf(stderr, "Failed to print JSON as a string.\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         free(cnt);
         return FALSE;
     }
     char *response_data = json_str;
 
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(response_data) +
-                           1;
+    // The printed JSON becomes the body, the response frees it once sent
+    http_response_json(response, 200, "OK", response_data, cJSON_free);
 
-    // Allocate memory for the response buffer
-    *response = (char *) malloc(response_size * sizeof(char));
+    release_statement(stmt);
 
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        sqlite3_finalize(stmt);
-        closeDatabase(db);
-        free(json_str);
-        free(cnt);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", response_data);
-
-    free(json_str);
-    sqlite3_finalize(stmt);
-
-    char *sql_not = sqlite3_mprintf(
-        "SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');",
-        cnt->pi);
-    if (sql_not == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        free(cnt);
-        return FALSE;
-    }
-    rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         free(cnt);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, cnt->pi, -1, SQLITE_STATIC);
 
     // Populate the CNT
     pthread_t thread_id;
@@ -778,83 +777,50 @@ char update_cnt(struct Route *destination, cJSON *content, char **response) {
     return TRUE;
 }
 
-char get_cnt(struct Route *destination, char **response) {
-    char *sql = sqlite3_mprintf("SELECT blob, pi FROM mtc WHERE LOWER(url) = LOWER('%s') AND et > datetime('now');",
-                                destination->key);
-
-    if (sql == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        return FALSE;
-    }
+char get_cnt(struct Route *destination, HTTPResponse *response) {
     sqlite3_stmt *stmt;
     struct sqlite3 *db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
         fprintf(stderr, "Failed to initialize the database.\n");
-        sqlite3_free(sql);
         return FALSE;
     }
-    short rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
+    stmt = prepare_statement(db, STMT_SELECT_CNT_BLOB);
+    if (stmt == NULL) {
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, destination->key, -1, SQLITE_STATIC);
+    short rc;
 
-    // Copy the blob from the resource to the response_data
+    // Copy the blob from the resource to the response_data, with the counters of the columns
     char *response_data = NULL;
     char *blob = NULL;
     char *pi = NULL;
     if ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         response_data = (char *) sqlite3_column_text(stmt, 0); // note the change in index to 0
-        blob = malloc(strlen(response_data));
-        strcpy(blob, response_data);
-        pi = malloc(strlen((char *) sqlite3_column_text(stmt, 1)));
+        blob = render_cnt(response_data, sqlite3_column_int(stmt, 2), sqlite3_column_int(stmt, 3));
+        pi = malloc(strlen((char *) sqlite3_column_text(stmt, 1)) + 1);
         strcpy(pi, (char *) sqlite3_column_text(stmt, 1));
     } else {
         fprintf(stderr, "Failed to print JSON as a string.\n");
         responseMessage(response, 400, "Bad Request", "Failed to print JSON as a string.\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
 
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(response_data) +
-                           1;
-
-    // Allocate memory for the response buffer
-    *response = (char *) malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        sqlite3_finalize(stmt);
-        closeDatabase(db);
-        free(response_data);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", response_data);
-    sqlite3_finalize(stmt);
+    // The blob copy becomes the body, the response frees it once sent
+    http_response_json(response, 200, "OK", blob, free);
+    release_statement(stmt);
 
     if (blob != NULL) {
-        char *sql_not = sqlite3_mprintf(
-            "SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');",
-            pi);
-        if (sql_not == NULL) {
-            fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-            responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-            return FALSE;
-        }
-        rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+        if (stmt == NULL) {
             responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-            sqlite3_finalize(stmt);
             closeDatabase(db);
             return FALSE;
         }
+        sqlite3_bind_text(stmt, 1, pi, -1, SQLITE_STATIC);
 
         // Populate the CNT
         pthread_t thread_id;
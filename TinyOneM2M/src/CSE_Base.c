@@ -108,7 +108,6 @@ char create_cse_base(CSEBaseStruct * csebase, char isTableCreated) {
         return FALSE;
     }
     strcpy(csebase->blob, cJSON_Print(csebase_to_json(csebase)));
-    char *err_msg = 0;
 
     short rc = begin_transaction(db);
     if (rc != SQLITE_OK) {
@@ -119,56 +118,14 @@ char create_cse_base(CSEBaseStruct * csebase, char isTableCreated) {
 
     if (isTableCreated == FALSE) {
 
-        // Create the table if it doesn't exist
-        const char *createTableSQL = "CREATE TABLE IF NOT EXISTS mtc (  ty INTEGER,  ri TEXT PRIMARY KEY,  rn TEXT,  pi TEXT,  aei TEXT,  csi TEXT,  cst INTEGER,  api TEXT,  rr TEXT,  et DATETIME,  ct DATETIME,  lt DATETIME,  url TEXT,  lbl TEXT,  acpi TEXT,  daci TEXT,  poa TEXT,  srt TEXT,  blob TEXT,  cbs INTEGER,  cni INTEGER,  mbs INTEGER,  mni INTEGER,  st INTEGER,  cnf TEXT,  cs INTEGER,  con TEXT, nu TEXT, enc TEXT, FOREIGN KEY(pi) REFERENCES mtc(ri) ON DELETE CASCADE);";
-        rc = sqlite3_exec(db, createTableSQL, NULL, NULL, &err_msg);
-        if (rc != SQLITE_OK) {
-            fprintf(stderr, "Failed to create table: %s\n", err_msg);
-            sqlite3_free(err_msg);
-        } else {
-            fprintf(stdout, "Table created successfully\n");
-        }
-
-        char *zErrMsg = 0;
-        const char *sql1 = "CREATE INDEX IF NOT EXISTS idx_mtc_pi ON mtc(pi);";
-        rc = sqlite3_exec(db, sql1, callback, 0, &zErrMsg);
-
-        if(rc != SQLITE_OK) {
-            fprintf(stderr, "SQL error: %s\n", zErrMsg);
-            sqlite3_free(zErrMsg);
-        } else {
-            fprintf(stdout, "Index idx_mtc_pi created successfully\n");
-        }
-
-        const char *sql2 = "CREATE INDEX IF NOT EXISTS idx_mtc_ri ON mtc(ri);";
-        rc = sqlite3_exec(db, sql2, callback, 0, &zErrMsg);
-
-        if(rc != SQLITE_OK) {
-            fprintf(stderr, "SQL error: %s\n", zErrMsg);
-            sqlite3_free(zErrMsg);
-        } else {
-            fprintf(stdout, "Index idx_mtc_ri created successfully\n");
-        }
-
-        const char *sql3 = "CREATE INDEX IF NOT EXISTS idx_mtc_et ON mtc(et);";
-        rc = sqlite3_exec(db, sql3, callback, 0, &zErrMsg);
-
-        if(rc != SQLITE_OK) {
-            fprintf(stderr, "SQL error: %s\n", zErrMsg);
-            sqlite3_free(zErrMsg);
-        } else {
-            fprintf(stdout, "Index idx_mtc_et created successfully\n");
-        }
-
-        const char *sql4 = "CREATE UNIQUE INDEX IF NOT EXISTS idx_mtc_url ON mtc(url);";
-        rc = sqlite3_exec(db, sql4, callback, 0, &zErrMsg);
-
-        if(rc != SQLITE_OK) {
-            fprintf(stderr, "SQL error: %s\n", zErrMsg);
-            sqlite3_free(zErrMsg);
-        } else {
-            fprintf(stdout, "Index idx_mtc_url created successfully\n");
+        // Create the tables, their indexes and the mtc view over them
+        if (create_schema(db) == FALSE) {
+            fprintf(stderr, "Failed to create the tables\n");
+            rollback_transaction(db);
+            closeDatabase(db);
+            return FALSE;
         }
+        fprintf(stdout, "Tables created successfully\n");
     }
    
     // Prepare the insert statement
@@ -236,7 +193,7 @@ char getLastCSEBaseStruct(CSEBaseStruct * csebase, sqlite3 *db) {
 
     // Prepare the SQL statement to retrieve the last row from the table
     
-    char *sql = sqlite3_mprintf("SELECT ty, ri, rn, pi, ct, lt FROM mtc WHERE ty = %d ORDER BY ROWID DESC LIMIT 1;", CSEBASE);
+    char *sql = sqlite3_mprintf("SELECT ty, ri, rn, pi, ct, lt FROM mtc_meta WHERE ty = %d ORDER BY ROWID DESC LIMIT 1;", CSEBASE);
     sqlite3_stmt *stmt;
     int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
     sqlite3_free(sql);
@@ -0,0 +1,102 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "Common.h"
+
+// Epoch based reclamation. Readers announce the epoch they entered in and never
+// wait. Writers unlink shared memory and retire it; it is freed once the epoch
+// has moved twice, when no reader can still hold a pointer to it.
+
+static atomic_ulong global_epoch = 0;
+static _Atomic(EpochThread *) threads = NULL;
+
+static pthread_mutex_t retired_lock = PTHREAD_MUTEX_INITIALIZER;
+static EpochRetired *retired = NULL;
+
+static __thread EpochThread *thread_epoch = NULL;
+
+// First read on a thread, its record stays on the list for the life of the process
+static EpochThread *register_thread(void) {
+    EpochThread *record = calloc(1, sizeof(EpochThread));
+    if (record == NULL) {
+        fprintf(stderr, "Failed to register the thread for epoch reclamation\n");
+        exit(EXIT_FAILURE);
+    }
+    EpochThread *head = atomic_load(&threads);
+    do {
+        record->next = head;
+    } while (!atomic_compare_exchange_weak(&threads, &head, record));
+    thread_epoch = record;
+    return record;
+}
+
+void epoch_enter(void) {
+    EpochThread *record = thread_epoch != NULL ? thread_epoch : register_thread();
+    atomic_store(&record->epoch, atomic_load(&global_epoch));
+    atomic_store(&record->active, TRUE);
+    // A writer that advanced the epoch before our flag was visible is caught here
+    atomic_store(&record->epoch, atomic_load(&global_epoch));
+}
+
+void epoch_exit(void) {
+    atomic_store_explicit(&thread_epoch->active, FALSE, memory_order_release);
+}
+
+// The epoch moves on only when every active reader has caught up with it
+static unsigned long try_advance(void) {
+    unsigned long epoch = atomic_load(&global_epoch);
+    for (EpochThread *record = atomic_load(&threads); record != NULL; record = record->next) {
+        if (atomic_load(&record->active) && atomic_load(&record->epoch) != epoch) {
+            return epoch;
+        }
+    }
+    atomic_compare_exchange_strong(&global_epoch, &epoch, epoch + 1);
+    return atomic_load(&global_epoch);
+}
+
+void epoch_retire(void *ptr, retire_fn release) {
+    EpochRetired *entry = malloc(sizeof(EpochRetired));
+    if (entry == NULL) {
+        // Leaking is the only safe thing left, a reader may still be on it
+        fprintf(stderr, "Failed to retire shared memory\n");
+        return;
+    }
+    entry->ptr = ptr;
+    entry->release = release;
+
+    pthread_mutex_lock(&retired_lock);
+    entry->epoch = atomic_load(&global_epoch);
+    entry->next = retired;
+    retired = entry;
+
+    unsigned long epoch = try_advance();
+    EpochRetired *ready = NULL;
+    for (EpochRetired **link = &retired; *link != NULL;) {
+        EpochRetired *current = *link;
+        if (current->epoch + 2 <= epoch) {
+            *link = current->next;
+            current->next = ready;
+            ready = current;
+        } else {
+            link = &current->next;
+        }
+    }
+    pthread_mutex_unlock(&retired_lock);
+
+    while (ready != NULL) {
+        EpochRetired *next = ready->next;
+        ready->release(ready->ptr);
+        free(ready);
+        ready = next;
+    }
+}
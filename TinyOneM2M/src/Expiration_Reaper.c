@@ -0,0 +1,220 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "Common.h"
+
+extern int EXPIRY_INTERVAL;
+extern int EXPIRY_BATCH_SIZE;
+
+static void free_expired(ExpiredResource *expired, int count) {
+    for (int i = 0; i < count; i++) {
+        free(expired[i].ri);
+        free(expired[i].pi);
+        free(expired[i].key);
+        free(expired[i].blob);
+    }
+    free(expired);
+}
+
+// Reads up to batch_size resources whose et has passed, soonest expiry first
+static int select_expired(sqlite3 *db, int batch_size, ExpiredResource *expired) {
+    sqlite3_stmt *stmt = prepare_statement(db, STMT_SELECT_EXPIRED);
+    if (stmt == NULL) {
+        return -1;
+    }
+    sqlite3_bind_int(stmt, 1, batch_size);
+
+    int count = 0;
+    int rc;
+    while (count < batch_size && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        ExpiredResource *resource = &expired[count];
+        resource->ri = strdup((const char *) sqlite3_column_text(stmt, 0));
+        resource->ty = sqlite3_column_int(stmt, 1);
+        resource->pi = strdup((const char *) sqlite3_column_text(stmt, 2));
+        resource->key = strdup((const char *) sqlite3_column_text(stmt, 3));
+        resource->cs = sqlite3_column_int(stmt, 4);
+        if (resource->ty == CNT) {
+            resource->blob = render_cnt((const char *) sqlite3_column_text(stmt, 7), sqlite3_column_int(stmt, 5), sqlite3_column_int(stmt, 6));
+        } else {
+            resource->blob = strdup((const char *) sqlite3_column_text(stmt, 7));
+        }
+        count++;
+        if (resource->ri == NULL || resource->pi == NULL || resource->key == NULL || resource->blob == NULL) {
+            fprintf(stderr, "Failed to read the expired resources: out of memory\n");
+            rc = SQLITE_NOMEM;
+            break;
+        }
+    }
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to read the expired resources: %s\n", sqlite3_errmsg(db));
+        release_statement(stmt);
+        free_expired(expired, count);
+        return -1;
+    }
+    release_statement(stmt);
+    return count;
+}
+
+// Deletes the resource and takes a CIN off its container's counters. Its
+// children go with it through the foreign keys.
+static char delete_expired(sqlite3 *db, const ExpiredResource *resource) {
+    if (resource->ty == CIN) {
+        sqlite3_stmt *stmt = prepare_statement(db, STMT_REMOVE_CNT_INSTANCES);
+        if (stmt == NULL) {
+            return FALSE;
+        }
+        sqlite3_bind_int(stmt, 1, 1);
+        sqlite3_bind_int(stmt, 2, resource->cs);
+        sqlite3_bind_text(stmt, 3, resource->pi, -1, SQLITE_STATIC);
+        int rc = sqlite3_step(stmt);
+        release_statement(stmt);
+        if (rc != SQLITE_DONE) {
+            fprintf(stderr, "Failed to update the CNT of %s: %s\n", resource->ri, sqlite3_errmsg(db));
+            return FALSE;
+        }
+    }
+
+    sqlite3_stmt *stmt = prepare_statement(db, STMT_DELETE_BY_RI);
+    if (stmt == NULL) {
+        return FALSE;
+    }
+    sqlite3_bind_text(stmt, 1, resource->ri, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    release_statement(stmt);
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to delete %s: %s\n", resource->ri, sqlite3_errmsg(db));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Deletes one batch of expired resources in a transaction, then drops their
+// routes and tells their subscribers. Returns how many were in the batch, -1 on error.
+int reap_expired(RouteTable *table, int batch_size) {
+    sqlite3 *db = initDatabase("tiny-oneM2M.db");
+    if (db == NULL) {
+        return -1;
+    }
+
+    ExpiredResource *expired = malloc(batch_size * sizeof(ExpiredResource));
+    if (expired == NULL) {
+        fprintf(stderr, "Failed to reap the expired resources: out of memory\n");
+        closeDatabase(db);
+        return -1;
+    }
+
+    if (begin_transaction(db) != SQLITE_OK) {
+        fprintf(stderr, "Can't begin transaction\n");
+        free(expired);
+        closeDatabase(db);
+        return -1;
+    }
+
+    int count = select_expired(db, batch_size, expired);
+    if (count <= 0) {
+        rollback_transaction(db);
+        if (count == 0) {
+            free(expired);
+        }
+        closeDatabase(db);
+        return count;
+    }
+
+    // A resource whose parent went earlier in the batch is already gone, deleting it again changes nothing
+    for (int i = 0; i < count; i++) {
+        if (delete_expired(db, &expired[i]) == FALSE) {
+            rollback_transaction(db);
+            free_expired(expired, count);
+            closeDatabase(db);
+            return -1;
+        }
+    }
+
+    // Snapshots wait until the table has caught up with the commit
+    route_change_begin(table);
+    if (commit_transaction(db) != SQLITE_OK) {
+        fprintf(stderr, "Can't commit transaction\n");
+        route_change_end(table);
+        free_expired(expired, count);
+        closeDatabase(db);
+        return -1;
+    }
+
+    // Drop the routes of each resource and everything below it
+    epoch_enter();
+    for (int i = 0; i < count; i++) {
+        struct Route *route = search(table, expired[i].key);
+        if (route != NULL) {
+            route_cache_remove_below(expired[i].key);
+            remove_subtree(table, route);
+        } else {
+            route_cache_remove(expired[i].key);
+        }
+    }
+    epoch_exit();
+    route_change_end(table);
+
+    for (int i = 0; i < count; i++) {
+        notify_subscribers(db, expired[i].pi, expired[i].blob, "DELETE");
+    }
+    printf("Reaped %d expired resources\n", count);
+
+    free_expired(expired, count);
+    closeDatabase(db);
+    return count;
+}
+
+static void *reaper_loop(void *arg) {
+    // Ctrl+C is handled on another thread
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    RouteTable *table = (RouteTable *) arg;
+    sqlite3 *db = initDatabase("tiny-oneM2M.db");
+    if (db == NULL) {
+        fprintf(stderr, "Expired resources will not be deleted\n");
+        return NULL;
+    }
+    // The children of an expired resource are deleted with it
+    char *err_msg = NULL;
+    if (sqlite3_exec(db, "PRAGMA foreign_keys=ON;", NULL, NULL, &err_msg) != SQLITE_OK) {
+        fprintf(stderr, "Failed to enable foreign keys: %s\n", err_msg);
+        sqlite3_free(err_msg);
+    }
+    closeDatabase(db);
+
+    while (TRUE) {
+        sleep(EXPIRY_INTERVAL);
+        // A full batch means there may be more, small batches keep the write lock short
+        while (reap_expired(table, EXPIRY_BATCH_SIZE) == EXPIRY_BATCH_SIZE);
+    }
+    return NULL;
+}
+
+char start_expiration_reaper(RouteTable *table) {
+    if (EXPIRY_INTERVAL <= 0 || EXPIRY_BATCH_SIZE <= 0) {
+        return FALSE;
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, reaper_loop, table) != 0) {
+        fprintf(stderr, "Failed to start the expiration reaper thread\n");
+        return FALSE;
+    }
+    pthread_detach(thread);
+    return TRUE;
+}
@@ -0,0 +1,333 @@
+/*
+ * Created on Tue Oct 13 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#include "HTTP_Parser.h"
+
+#define TRUE 1
+#define FALSE 0
+
+// Longest chunk size line or trailer line accepted in a chunked body
+#define HTTP_MAX_LINE_SIZE 1024
+
+void http_request_reset(HTTPRequest *request) {
+    memset(request, 0, sizeof(HTTPRequest));
+    request->state = HTTP_STATE_HEAD;
+}
+
+// Offset of the next "\r\n" at or after from, or -1
+static long find_crlf(const char *buffer, size_t from, size_t length) {
+    for (size_t i = from; i + 1 < length; i++) {
+        if (buffer[i] == '\r' && buffer[i + 1] == '\n') {
+            return (long) i;
+        }
+    }
+    return -1;
+}
+
+// Case insensitive search for a comma separated token (e.g. "close" in "keep-alive, close")
+static char has_token(const char *value, const char *token) {
+    size_t token_length = strlen(token);
+    const char *p = value;
+    while (*p != '\0') {
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+        const char *end = p;
+        while (*end != '\0' && *end != ',') {
+            end++;
+        }
+        const char *last = end;
+        while (last > p && (last[-1] == ' ' || last[-1] == '\t')) {
+            last--;
+        }
+        if ((size_t) (last - p) == token_length && strncasecmp(p, token, token_length) == 0) {
+            return TRUE;
+        }
+        p = end;
+    }
+    return FALSE;
+}
+
+// Cuts the next token ending with delimiter out of [*position, end), terminating it in place
+static char take_token(char *buffer, size_t *position, size_t end, char delimiter, HTTPSlice *slice) {
+    size_t start = *position;
+    size_t i = start;
+    while (i < end && buffer[i] != delimiter) {
+        i++;
+    }
+    if (i == start || (i == end && delimiter != '\r')) {
+        return FALSE;
+    }
+    buffer[i] = '\0';
+    slice->offset = start;
+    slice->length = i - start;
+    *position = i + 1;
+    return TRUE;
+}
+
+static char parse_head(HTTPRequest *request, char *buffer, size_t head_start, size_t head_end) {
+    size_t position = head_start;
+    long line_end = find_crlf(buffer, position, head_end);
+    if (line_end < 0) {
+        return FALSE;
+    }
+
+    HTTPSlice target;
+    if (take_token(buffer, &position, line_end, ' ', &request->method) == FALSE ||
+        take_token(buffer, &position, line_end, ' ', &target) == FALSE ||
+        take_token(buffer, &position, line_end + 1, '\r', &request->version) == FALSE) {
+        return FALSE;
+    }
+    if (strncmp(http_slice(buffer, request->version), "HTTP/1.", 7) != 0) {
+        return FALSE;
+    }
+
+    // Split the target into path and query string. Without a query the slice points at
+    // the path terminator so it still reads as an empty string.
+    char *question = memchr(http_slice(buffer, target), '?', target.length);
+    request->path.offset = target.offset;
+    if (question != NULL) {
+        *question = '\0';
+        request->path.length = question - http_slice(buffer, target);
+        request->query.offset = request->path.offset + request->path.length + 1;
+        request->query.length = target.length - request->path.length - 1;
+    } else {
+        request->path.length = target.length;
+        request->query.offset = target.offset + target.length;
+        request->query.length = 0;
+    }
+
+    request->keep_alive = strcmp(http_slice(buffer, request->version), "HTTP/1.1") == 0 ? TRUE : FALSE;
+
+    char has_content_length = FALSE;
+    position = line_end + 2;
+    while (position + 2 <= head_end) {
+        line_end = find_crlf(buffer, position, head_end);
+        if (line_end < 0 || (size_t) line_end == position) {
+            break;
+        }
+
+        if (request->num_headers == HTTP_MAX_HEADERS) {
+            fprintf(stderr, "Too many headers in request\n");
+            return FALSE;
+        }
+        HTTPHeader *header = &request->headers[request->num_headers++];
+        if (take_token(buffer, &position, line_end, ':', &header->name) == FALSE) {
+            return FALSE;
+        }
+
+        // Trim the optional whitespace around the value
+        size_t value_end = line_end;
+        while (position < value_end && (buffer[position] == ' ' || buffer[position] == '\t')) {
+            position++;
+        }
+        while (value_end > position && (buffer[value_end - 1] == ' ' || buffer[value_end - 1] == '\t')) {
+            value_end--;
+        }
+        buffer[value_end] = '\0';
+        header->value.offset = position;
+        header->value.length = value_end - position;
+
+        const char *name = http_slice(buffer, header->name);
+        const char *value = http_slice(buffer, header->value);
+        if (strcasecmp(name, "Content-Length") == 0) {
+            char *number_end = NULL;
+            if (!isdigit((unsigned char) value[0])) {
+                return FALSE;
+            }
+            unsigned long long content_length = strtoull(value, &number_end, 10);
+            if (*number_end != '\0' || content_length > (size_t) -1 / 2) {
+                return FALSE;
+            }
+            // Repeated headers must agree, anything else is a smuggling attempt
+            if (has_content_length && request->content_length != content_length) {
+                return FALSE;
+            }
+            has_content_length = TRUE;
+            request->content_length = (size_t) content_length;
+        } else if (strcasecmp(name, "Transfer-Encoding") == 0) {
+            if (has_token(value, "chunked") == FALSE) {
+                return FALSE;
+            }
+            request->chunked = TRUE;
+        } else if (strcasecmp(name, "Connection") == 0) {
+            if (has_token(value, "close")) {
+                request->keep_alive = FALSE;
+            } else if (has_token(value, "keep-alive")) {
+                request->keep_alive = TRUE;
+            }
+        }
+
+        position = line_end + 2;
+    }
+
+    if (request->chunked && has_content_length) {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Parses as much of the request as the buffer holds. Call again with the same
+// request after more bytes arrive; already scanned bytes are not looked at twice.
+// A request that would take more than max_size bytes of the buffer is turned
+// down as soon as that is known, before its body is read.
+int http_parse_request(HTTPRequest *request, char *buffer, size_t length, size_t max_size) {
+    while (TRUE) {
+        switch (request->state) {
+            case HTTP_STATE_HEAD: {
+                // Stray empty lines between pipelined requests are allowed before the request line
+                size_t head_start = 0;
+                while (head_start < length && (buffer[head_start] == '\r' || buffer[head_start] == '\n')) {
+                    head_start++;
+                }
+
+                // Resume a few bytes back in case the terminator was split between reads
+                size_t i = request->scanned > head_start + 3 ? request->scanned - 3 : head_start;
+                size_t head_end = 0;
+                for (; i + 3 < length; i++) {
+                    if (buffer[i] == '\r' && buffer[i + 1] == '\n' && buffer[i + 2] == '\r' && buffer[i + 3] == '\n') {
+                        head_end = i + 4;
+                        break;
+                    }
+                }
+                if (head_end == 0) {
+                    request->scanned = length;
+                    return length > HTTP_MAX_HEAD_SIZE ? HTTP_PARSE_ERROR : HTTP_PARSE_INCOMPLETE;
+                }
+                if (head_end > HTTP_MAX_HEAD_SIZE || parse_head(request, buffer, head_start, head_end) == FALSE) {
+                    return HTTP_PARSE_ERROR;
+                }
+
+                if (!request->chunked && (head_end > max_size || request->content_length > max_size - head_end)) {
+                    return HTTP_PARSE_TOO_LARGE;
+                }
+
+                request->body.offset = head_end;
+                request->body.length = 0;
+                request->scanned = head_end;
+                if (request->chunked) {
+                    request->state = HTTP_STATE_CHUNK_SIZE;
+                } else if (request->content_length > 0) {
+                    request->state = HTTP_STATE_BODY;
+                } else {
+                    request->length = head_end;
+                    request->state = HTTP_STATE_DONE;
+                }
+                break;
+            }
+            case HTTP_STATE_BODY:
+                if (length - request->body.offset < request->content_length) {
+                    return HTTP_PARSE_INCOMPLETE;
+                }
+                request->body.length = request->content_length;
+                request->length = request->body.offset + request->content_length;
+                request->state = HTTP_STATE_DONE;
+                break;
+            case HTTP_STATE_CHUNK_SIZE: {
+                long line_end = find_crlf(buffer, request->scanned, length);
+                if (line_end < 0) {
+                    return length - request->scanned > HTTP_MAX_LINE_SIZE ? HTTP_PARSE_ERROR : HTTP_PARSE_INCOMPLETE;
+                }
+                if (!isxdigit((unsigned char) buffer[request->scanned])) {
+                    return HTTP_PARSE_ERROR;
+                }
+                // Chunk extensions after ';' are ignored
+                size_t chunk_size = 0;
+                size_t i = request->scanned;
+                for (; i < (size_t) line_end && isxdigit((unsigned char) buffer[i]); i++) {
+                    if (chunk_size > ((size_t) -1 >> 5)) {
+                        return HTTP_PARSE_ERROR;
+                    }
+                    char c = buffer[i];
+                    chunk_size = chunk_size * 16 + (isdigit((unsigned char) c) ? c - '0' : (tolower((unsigned char) c) - 'a' + 10));
+                }
+                if (i < (size_t) line_end && buffer[i] != ';' && buffer[i] != ' ' && buffer[i] != '\t') {
+                    return HTTP_PARSE_ERROR;
+                }
+
+                // The chunk is counted where it arrives, before it is joined to the body
+                if (chunk_size > max_size || (size_t) line_end + 2 + chunk_size > max_size) {
+                    return HTTP_PARSE_TOO_LARGE;
+                }
+
+                request->scanned = line_end + 2;
+                if (chunk_size == 0) {
+                    request->state = HTTP_STATE_TRAILER;
+                } else {
+                    request->chunk_remaining = chunk_size;
+                    request->state = HTTP_STATE_CHUNK_DATA;
+                }
+                break;
+            }
+            case HTTP_STATE_CHUNK_DATA: {
+                // Slide the chunk down so the body stays one contiguous slice
+                size_t available = length - request->scanned;
+                size_t n = available < request->chunk_remaining ? available : request->chunk_remaining;
+                size_t write_at = request->body.offset + request->body.length;
+                if (write_at != request->scanned) {
+                    memmove(buffer + write_at, buffer + request->scanned, n);
+                }
+                request->body.length += n;
+                request->scanned += n;
+                request->chunk_remaining -= n;
+                if (request->chunk_remaining > 0) {
+                    return HTTP_PARSE_INCOMPLETE;
+                }
+                request->state = HTTP_STATE_CHUNK_END;
+                break;
+            }
+            case HTTP_STATE_CHUNK_END:
+                if (length - request->scanned < 2) {
+                    return HTTP_PARSE_INCOMPLETE;
+                }
+                if (buffer[request->scanned] != '\r' || buffer[request->scanned + 1] != '\n') {
+                    return HTTP_PARSE_ERROR;
+                }
+                request->scanned += 2;
+                request->state = HTTP_STATE_CHUNK_SIZE;
+                break;
+            case HTTP_STATE_TRAILER: {
+                // Trailer fields are skipped up to the empty line that ends the message
+                long line_end = find_crlf(buffer, request->scanned, length);
+                if (line_end < 0) {
+                    return length - request->scanned > HTTP_MAX_LINE_SIZE ? HTTP_PARSE_ERROR : HTTP_PARSE_INCOMPLETE;
+                }
+                if ((size_t) line_end + 2 > max_size) {
+                    return HTTP_PARSE_TOO_LARGE;
+                }
+                if ((size_t) line_end == request->scanned) {
+                    request->length = line_end + 2;
+                    request->state = HTTP_STATE_DONE;
+                } else {
+                    request->scanned = line_end + 2;
+                }
+                break;
+            }
+            case HTTP_STATE_DONE:
+                return HTTP_PARSE_DONE;
+            default:
+                return HTTP_PARSE_ERROR;
+        }
+    }
+}
+
+const char *http_get_header(const HTTPRequest *request, const char *buffer, const char *name) {
+    for (int i = 0; i < request->num_headers; i++) {
+        if (strcasecmp(http_slice(buffer, request->headers[i].name), name) == 0) {
+            return http_slice(buffer, request->headers[i].value);
+        }
+    }
+    return NULL;
+}
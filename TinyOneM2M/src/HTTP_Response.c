@@ -0,0 +1,177 @@
+/*
+ * Created on Wed Oct 14 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "HTTP_Response.h"
+
+#define TRUE 1
+#define FALSE 0
+
+// Seconds a whole response may take to go out to a client that reads slowly
+extern int WRITE_TIMEOUT;
+
+static long elapsed_ms(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+void http_response_init(HTTPResponse *response) {
+    memset(response, 0, sizeof(HTTPResponse));
+}
+
+// Releases the owned slices and forgets status and headers
+void http_response_reset(HTTPResponse *response) {
+    for (int i = 0; i < response->num_slices; i++) {
+        if (response->slices[i].release != NULL) {
+            response->slices[i].release((void *) response->slices[i].data);
+        }
+    }
+    http_response_init(response);
+}
+
+void http_response_status(HTTPResponse *response, int status_code, const char *status_message, const char *content_type) {
+    response->status_code = status_code;
+    snprintf(response->status_line, sizeof(response->status_line), "HTTP/1.1 %d %s", status_code, status_message);
+    response->content_type = content_type;
+}
+
+char http_response_header(HTTPResponse *response, const char *name, const char *value) {
+    size_t available = sizeof(response->headers) - response->headers_length;
+    int n = snprintf(response->headers + response->headers_length, available, "%s: %s\r\n", name, value);
+    if (n < 0 || (size_t) n >= available) {
+        response->headers[response->headers_length] = '\0';
+        fprintf(stderr, "No room for the %s header\n", name);
+        return FALSE;
+    }
+    response->headers_length += n;
+    return TRUE;
+}
+
+// Adds data to the end of the body without copying it. On failure the data is
+// released right away, so callers never have to clean up after this call.
+char http_response_body(HTTPResponse *response, const char *data, size_t length, release_fn release) {
+    if (response->num_slices == HTTP_RESPONSE_MAX_SLICES) {
+        fprintf(stderr, "Too many body slices in response\n");
+        if (release != NULL) {
+            release((void *) data);
+        }
+        return FALSE;
+    }
+    HTTPBodySlice *slice = &response->slices[response->num_slices++];
+    slice->data = data;
+    slice->length = length;
+    slice->release = release;
+    response->body_length += length;
+    return TRUE;
+}
+
+// Replaces whatever the response held with a JSON document
+char http_response_json(HTTPResponse *response, int status_code, const char *status_message, char *json, release_fn release) {
+    http_response_reset(response);
+    http_response_status(response, status_code, status_message, "application/json");
+    return http_response_body(response, json, strlen(json), release);
+}
+
+// Formats the status line and headers, including the framing ones. Returns the
+// head length or 0 when it does not fit in size bytes.
+size_t http_response_head(HTTPResponse *response, char *head, size_t size, char keep_alive) {
+    if (response->status_code == 0) {
+        http_response_status(response, 500, "Internal Server Error", NULL);
+    }
+
+    // A 304 carries no body, a Content-Length there would describe the cached one
+    char content_length[48] = "";
+    if (response->status_code != 304) {
+        snprintf(content_length, sizeof(content_length), "Content-Length: %zu\r\n", response->body_length);
+    }
+
+    int head_length = snprintf(head, size, "%s\r\n%s%s%s%s%sConnection: %s\r\n\r\n",
+        response->status_line,
+        response->content_type != NULL ? "Content-Type: " : "",
+        response->content_type != NULL ? response->content_type : "",
+        response->content_type != NULL ? "\r\n" : "",
+        response->headers,
+        content_length,
+        keep_alive ? "keep-alive" : "close");
+    if (head_length < 0 || (size_t) head_length >= size) {
+        return 0;
+    }
+    return head_length;
+}
+
+// Writes the head and every body slice with one sendmsg per attempt, waiting on the
+// socket when its send queue is full. Gives up once WRITE_TIMEOUT has passed in total,
+// so a client reading a byte at a time cannot keep the worker.
+char http_response_send(HTTPResponse *response, int socket_desc, char keep_alive) {
+    char head[HTTP_RESPONSE_HEAD_SIZE];
+    size_t head_length = http_response_head(response, head, sizeof(head), keep_alive);
+    if (head_length == 0) {
+        return FALSE;
+    }
+
+    struct iovec iov[HTTP_RESPONSE_MAX_SLICES + 1];
+    int iov_count = 0;
+    iov[iov_count].iov_base = head;
+    iov[iov_count++].iov_len = head_length;
+    for (int i = 0; i < response->num_slices; i++) {
+        if (response->slices[i].length > 0) {
+            iov[iov_count].iov_base = (void *) response->slices[i].data;
+            iov[iov_count++].iov_len = response->slices[i].length;
+        }
+    }
+
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    struct iovec *pending = iov;
+    while (iov_count > 0) {
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = pending;
+        message.msg_iovlen = iov_count;
+
+        ssize_t n = sendmsg(socket_desc, &message, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                long remaining = WRITE_TIMEOUT * 1000L - elapsed_ms(&started);
+                struct pollfd pfd = { .fd = socket_desc, .events = POLLOUT };
+                if (remaining <= 0 || poll(&pfd, 1, (int) remaining) <= 0) {
+                    return FALSE;
+                }
+                continue;
+            }
+            return FALSE;
+        }
+
+        // Skip what was written, possibly stopping in the middle of a slice
+        while (iov_count > 0 && (size_t) n >= pending->iov_len) {
+            n -= pending->iov_len;
+            pending++;
+            iov_count--;
+        }
+        if (iov_count > 0) {
+            pending->iov_base = (char *) pending->iov_base + n;
+            pending->iov_len -= n;
+        }
+    }
+
+    return TRUE;
+}
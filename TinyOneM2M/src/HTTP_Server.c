@@ -13,23 +13,60 @@
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 
-void init_server(HTTP_Server * http_server, int port) {
-	http_server->port = port;
+extern int LISTENERS;
+extern int LISTEN_BACKLOG;
+extern int DEFER_ACCEPT;
+extern int NODELAY;
+
+// SO_REUSEPORT lets a second server bind the same port without an error, the
+// lock makes sure only one of them runs on this database. The descriptor stays
+// open so the lock is held until the process exits.
+int lock_instance(const char *path) {
+	int lock_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (lock_fd < 0) {
+        fprintf(stderr, "Failed to open lock file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
 
-	int server_socket = socket(AF_INET, SOCK_STREAM, 0);
+	if (flock(lock_fd, LOCK_EX | LOCK_NB) < 0) {
+        if (errno == EWOULDBLOCK) {
+            fprintf(stderr, "Another server is already running on %s\n", path);
+        } else {
+            fprintf(stderr, "Failed to lock %s: %s\n", path, strerror(errno));
+        }
+        close(lock_fd);
+        return -1;
+    }
+
+	return lock_fd;
+}
+
+static int open_listener(int port) {
+	int server_socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
 	if (server_socket < 0) {
         perror("socket");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
-	// Enable reuse of the port
+	// Enable reuse of the port, every listener binds the same address
     int optval = 1;
-    if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) < 0) {
+    if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) < 0 ||
+        setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)) < 0) {
         perror("setsockopt");
-        exit(EXIT_FAILURE);
+        close(server_socket);
+        return -1;
+    }
+
+	// Only wake the reactor once the client sent its request
+	if (DEFER_ACCEPT > 0 && setsockopt(server_socket, IPPROTO_TCP, TCP_DEFER_ACCEPT, &DEFER_ACCEPT, sizeof(DEFER_ACCEPT)) < 0) {
+        perror("setsockopt TCP_DEFER_ACCEPT");
     }
 
 	// Bind the socket to the desired port
@@ -41,17 +78,62 @@ void init_server(HTTP_Server * http_server, int port) {
 
 	if (bind(server_socket, (struct sockaddr *)&server_address, sizeof(server_address)) < 0) {
         fprintf(stderr, "Failed to bind to port %d: %s\n", port, strerror(errno));
-        // Try another port
-        port++;
-        server_address.sin_port = htons(port);
-        if (bind(server_socket, (struct sockaddr *)&server_address, sizeof(server_address)) < 0) {
-            perror("bind");
-            exit(EXIT_FAILURE);
-        }
+        close(server_socket);
+        return -1;
     }
 
-	listen(server_socket, 5);
+	if (listen(server_socket, LISTEN_BACKLOG) < 0) {
+        perror("listen");
+        close(server_socket);
+        return -1;
+    }
+
+	return server_socket;
+}
+
+void init_server(HTTP_Server * http_server, int port) {
+	http_server->port = port;
+
+	int listeners = LISTENERS;
+	if (listeners <= 0) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		listeners = cores > 0 ? (int) cores : 1;
+	}
+
+	http_server->sockets = (int *) malloc(sizeof(int) * listeners);
+	if (http_server->sockets == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+	http_server->num_sockets = 0;
+
+	for (int i = 0; i < listeners; i++) {
+		int server_socket = open_listener(port);
+		if (server_socket < 0) {
+			close_server(http_server);
+			exit(EXIT_FAILURE);
+		}
+		http_server->sockets[http_server->num_sockets++] = server_socket;
+	}
+
+	http_server->socket = http_server->sockets[0];
+	printf("HTTP Server Initialized\nPort: %d\nListeners: %d (backlog %d)\n", port, http_server->num_sockets, LISTEN_BACKLOG);
+}
+
+void close_server(HTTP_Server * http_server) {
+	for (int i = 0; i < http_server->num_sockets; i++) {
+		close(http_server->sockets[i]);
+	}
+	free(http_server->sockets);
+	http_server->sockets = NULL;
+	http_server->num_sockets = 0;
+	http_server->socket = -1;
+}
 
-	http_server->socket = server_socket;
-	printf("HTTP Server Initialized\nPort: %d\n", port);
+// Options that apply to every accepted connection
+void configure_client_socket(int client_socket) {
+	if (NODELAY) {
+		int optval = 1;
+		setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+	}
 }
@@ -0,0 +1,147 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "Common.h"
+
+extern char DB_MEM[MAX_CONFIG_LINE_LENGTH];
+extern int ID_BLOCK_SIZE;
+
+// Resource IDs are the prefix followed by a number that only goes up
+typedef struct {
+    short ty;
+    const char *prefix;
+    atomic_long next;
+    atomic_long reserved; // numbers below it are already recorded in id_sequence
+} IdCounter;
+
+static IdCounter counters[] = {
+    {.ty = AE, .prefix = "CAE"},
+    {.ty = CNT, .prefix = "CCNT"},
+    {.ty = CIN, .prefix = "CCIN"},
+    {.ty = SUB, .prefix = "CSUB"},
+};
+#define NUM_COUNTERS (sizeof(counters) / sizeof(counters[0]))
+
+static pthread_mutex_t reserve_lock = PTHREAD_MUTEX_INITIALIZER;
+static char persist_blocks = FALSE;
+
+static IdCounter *find_counter(short ty) {
+    for (size_t i = 0; i < NUM_COUNTERS; i++) {
+        if (counters[i].ty == ty) {
+            return &counters[i];
+        }
+    }
+    return NULL;
+}
+
+static long select_long(sqlite3 *db, const char *sql, short ty, long fallback) {
+    sqlite3_stmt *stmt;
+    long value = fallback;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        return fallback;
+    }
+    sqlite3_bind_int(stmt, 1, ty);
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        value = (long) sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+// The table is scanned once here, after that an ID costs an atomic increment.
+// id_sequence keeps the numbers handed out before a restart from coming back
+// even when their resources were deleted in the meantime.
+char init_id_allocator(void) {
+    sqlite3 *db = initDatabase("tiny-oneM2M.db");
+    if (db == NULL) {
+        return FALSE;
+    }
+
+    persist_blocks = ID_BLOCK_SIZE > 0 && strcmp(DB_MEM, "true") != 0;
+    if (persist_blocks) {
+        char *err_msg = NULL;
+        int rc = sqlite3_exec(db, "CREATE TABLE IF NOT EXISTS id_sequence (ty INTEGER PRIMARY KEY, next INTEGER NOT NULL);", NULL, NULL, &err_msg);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "Failed to create the id sequence: %s\n", err_msg);
+            sqlite3_free(err_msg);
+            persist_blocks = FALSE;
+        }
+    }
+
+    for (size_t i = 0; i < NUM_COUNTERS; i++) {
+        IdCounter *counter = &counters[i];
+        char *sql = sqlite3_mprintf("SELECT MAX(CAST(substr(ri, %d) AS INTEGER)) FROM mtc_meta WHERE ty = ?;", (int) strlen(counter->prefix) + 1);
+        long next = select_long(db, sql, counter->ty, 0) + 1;
+        sqlite3_free(sql);
+        if (persist_blocks) {
+            long recorded = select_long(db, "SELECT next FROM id_sequence WHERE ty = ?;", counter->ty, 0);
+            if (recorded > next) {
+                next = recorded;
+            }
+        }
+        atomic_store(&counter->next, next);
+        // The first ID taken reserves the first block
+        atomic_store(&counter->reserved, persist_blocks ? next : LONG_MAX);
+    }
+
+    closeDatabase(db);
+    return TRUE;
+}
+
+// Records that every number below reserved has been handed out, one write per block
+static void reserve_block(sqlite3 *db, IdCounter *counter, long id) {
+    pthread_mutex_lock(&reserve_lock);
+    long reserved = atomic_load(&counter->reserved);
+    if (id >= reserved) {
+        while (id >= reserved) {
+            reserved += ID_BLOCK_SIZE;
+        }
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO id_sequence (ty, next) VALUES (?, ?);", -1, &stmt, NULL) == SQLITE_OK) {
+            sqlite3_bind_int(stmt, 1, counter->ty);
+            sqlite3_bind_int64(stmt, 2, reserved);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                fprintf(stderr, "Failed to reserve ids: %s\n", sqlite3_errmsg(db));
+            }
+            sqlite3_finalize(stmt);
+        } else {
+            fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        }
+        // Even if the write failed the block is used, the startup scan still
+        // sees every ID that made it into mtc
+        atomic_store(&counter->reserved, reserved);
+    }
+    pthread_mutex_unlock(&reserve_lock);
+}
+
+// Writes the next ID of the resource type to ri. db is the caller's connection,
+// it is only written to when a new block has to be reserved.
+char allocate_id(sqlite3 *db, short ty, char *ri, size_t size) {
+    IdCounter *counter = find_counter(ty);
+    if (counter == NULL) {
+        fprintf(stderr, "No ids are allocated for resource type %d\n", ty);
+        return FALSE;
+    }
+    long id = atomic_fetch_add(&counter->next, 1);
+    if (id >= atomic_load(&counter->reserved)) {
+        reserve_block(db, counter, id);
+    }
+    int written = snprintf(ri, size, "%s%ld", counter->prefix, id);
+    if (written < 0 || (size_t) written >= size) {
+        fprintf(stderr, "Resource id does not fit in %zu bytes\n", size);
+        return FALSE;
+    }
+    return TRUE;
+}
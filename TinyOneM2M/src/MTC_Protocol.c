@@ -9,7 +9,7 @@
 
 #include "Common.h"
 
-char init_protocol(struct Route** head) {
+char init_protocol(RouteTable *routes) {
 
     char rs = init_types();
     if (rs == FALSE) {
@@ -38,7 +38,7 @@ char init_protocol(struct Route** head) {
 
     // Check if the cse_base exists
     sqlite3_stmt *stmt;
-    short rc = sqlite3_prepare_v2(db, "SELECT name FROM sqlite_master WHERE type='table' AND name='mtc';", -1, &stmt, NULL);
+    short rc = sqlite3_prepare_v2(db, "SELECT name FROM sqlite_master WHERE type IN ('table', 'view') AND name='mtc';", -1, &stmt, NULL);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Failed to prepare query: %s\n", sqlite3_errmsg(db));
         pthread_mutex_unlock(&db_mutex);
@@ -52,7 +52,7 @@ char init_protocol(struct Route** head) {
         fprintf(stderr, "Error allocating memory for CSEBaseStruct.\n");
         pthread_mutex_unlock(&db_mutex);
         pthread_mutex_destroy(&db_mutex);
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
@@ -61,7 +61,7 @@ char init_protocol(struct Route** head) {
     if (rc != SQLITE_ROW) {
         // If table doesn't exist, we create it and populate it
         printf("The table does not exist.\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         
         char rs = create_cse_base(csebase, FALSE);
         if (rs == FALSE) {
@@ -73,11 +73,21 @@ char init_protocol(struct Route** head) {
             return FALSE;
         }
     } else {
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
+
+        // Databases from older builds get the tables and indexes the hot queries use
+        if (upgrade_database(db) == FALSE) {
+            fprintf(stderr, "Error upgrading the database.\n");
+            pthread_mutex_unlock(&db_mutex);
+            pthread_mutex_destroy(&db_mutex);
+            closeDatabase(db);
+            free(csebase);
+            return FALSE;
+        }
 
         // Check if the table has any data
         sqlite3_stmt *stmt;
-        char *sql = sqlite3_mprintf("SELECT COUNT(*) FROM mtc WHERE ty = %d ORDER BY ROWID DESC LIMIT 1;", CSEBASE);
+        char *sql = sqlite3_mprintf("SELECT COUNT(*) FROM mtc_meta WHERE ty = %d ORDER BY ROWID DESC LIMIT 1;", CSEBASE);
         rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
         sqlite3_free(sql);
         if (rc != SQLITE_OK) {
@@ -92,7 +102,7 @@ char init_protocol(struct Route** head) {
         rc = sqlite3_step(stmt);
         if (rc != SQLITE_ROW) {
             fprintf(stderr, "Failed to execute 'SELECT COUNT(*) FROM mtc WHERE ty = %d;' query: %s\n", CSEBASE, sqlite3_errmsg(db));
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             pthread_mutex_unlock(&db_mutex);
             pthread_mutex_destroy(&db_mutex);
             closeDatabase(db);
@@ -101,7 +111,7 @@ char init_protocol(struct Route** head) {
         }
 
         int rowCount = sqlite3_column_int(stmt, 0);
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
 
         if (rowCount == 0) {
             printf("The mtc table doesn't have CSE_Base resources.\n");
@@ -130,6 +140,19 @@ char init_protocol(struct Route** head) {
         }
     }
 
+    // A statement that lost its index reads every resource on each request,
+    // debug builds refuse to start with one
+    if (check_query_plans(db) == FALSE) {
+#ifndef NDEBUG
+        fprintf(stderr, "A cached statement does not use an index.\n");
+        pthread_mutex_unlock(&db_mutex);
+        pthread_mutex_destroy(&db_mutex);
+        closeDatabase(db);
+        free(csebase);
+        return FALSE;
+#endif
+    }
+
     // Access database here
     pthread_mutex_unlock(&db_mutex);
     pthread_mutex_destroy(&db_mutex);
@@ -139,7 +162,7 @@ char init_protocol(struct Route** head) {
     char uri[URI_BUFFER_SIZE];
     snprintf(uri, sizeof(uri), "/%s", csebase->rn);
     to_lowercase(uri);
-    addRoute(head, uri, csebase->ri, csebase->ty, csebase->rn);
+    addRoute(routes, uri, csebase->ri, csebase->ty, csebase->rn);
 
     // The DB connection should exist in each thread and should not be shared
     if (closeDatabase(db) == FALSE) {
@@ -150,22 +173,21 @@ char init_protocol(struct Route** head) {
     return TRUE;
 }
 
-char retrieve_csebase(struct Route * destination, char **response) {
-    char *sql = sqlite3_mprintf("SELECT blob FROM mtc WHERE ri = '%s' AND ty = %d;", destination->ri, destination->ty);
+char retrieve_csebase(struct Route * destination, HTTPResponse *response) {
     sqlite3_stmt *stmt;
     struct sqlite3 * db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
         responseMessage(response, 500, "Internal Server Error", "Could not open the database");
         return FALSE;
     }
-    short rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_BLOB_BY_RI_TY);
+    if (stmt == NULL) {
         responseMessage(response, 500, "Internal Server Error", "Failed to prepare statement");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, destination->ri, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, destination->ty);
 
     printf("Creating the json object\n");
     CSEBaseStruct *csebase = init_cse_base();
@@ -180,36 +202,21 @@ char retrieve_csebase(struct Route * destination, char **response) {
     char *json_str = csebase->blob;
     if (json_str == NULL) {
         fprintf(stderr, "Failed to print JSON as a string.\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
     
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(json_str) + 1;
-    
-    // Allocate memory for the response buffer
-    *response = (char *)malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        sqlite3_finalize(stmt);
-        closeDatabase(db);
-        free(json_str);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", json_str);
+    // The blob copy is sent as the body and freed by the response
+    http_response_json(response, 200, "OK", json_str, free);
 
-    sqlite3_finalize(stmt);
+    release_statement(stmt);
     closeDatabase(db);
-    free(json_str);
 
     return TRUE;
 }
 
-char discovery(struct Route *head, struct Route *destination, const char *queryString, char **response) {
+char discovery(RouteTable *routes, struct Route *destination, const char *queryString, HTTPResponse *response) {
     // Initialize the database
     struct sqlite3 *db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
@@ -317,7 +324,7 @@ char discovery(struct Route *head, struct Route *destination, const char *queryS
             if (strcmp(key, "ty") == 0) {  // Integer key
                 condition = sqlite3_mprintf("%s %s = %Q", filter_operation, key, value);
             } else {  // String key
-                condition = sqlite3_mprintf("%s %s LIKE \"%%%s%%\"", filter_operation, key, value);
+                condition = sqlite3_mprintf("%s %s LIKE '%%%q%%'", filter_operation, key, value);
             }
             
             char *newMTCconditions = sqlite3_mprintf("%s%s ", MTCconditions ? MTCconditions : "", condition);
@@ -402,14 +409,12 @@ char discovery(struct Route *head, struct Route *destination, const char *queryS
         }
     }
 
-    // Execute the dynamic SELECT statement
-    char *query = sqlite3_mprintf("SELECT * FROM (SELECT url FROM mtc WHERE ri = \"%s\" AND 1 = 1%s LIMIT %d) "
+    // Execute the dynamic SELECT statement, the filters change its text so it is not cached
+    char *query = sqlite3_mprintf("SELECT * FROM (SELECT url FROM mtc WHERE ri = ?1 AND 1 = 1%s LIMIT %d) "
                               "UNION "
-                              "SELECT mtc.url FROM mtc WHERE mtc.pi = \"%s\" AND mtc.et > datetime('now') AND 1=1%s LIMIT %d",
-                              destination->ri,
+                              "SELECT mtc.url FROM mtc WHERE mtc.pi = ?1 AND 1=1%s LIMIT %d",
                               MTCconditions ? MTCconditions : "",
                               limit,
-                              destination->ri,
                               MTCconditions ? MTCconditions : "",
                               limit);
 
@@ -428,6 +433,7 @@ char discovery(struct Route *head, struct Route *destination, const char *queryS
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, destination->ri, -1, SQLITE_STATIC);
 
     cJSON *root = cJSON_CreateObject();
     cJSON *uril_array = cJSON_CreateArray();
@@ -441,7 +447,7 @@ char discovery(struct Route *head, struct Route *destination, const char *queryS
         cJSON_AddItemToArray(uril_array, mtc_ri_value);
     }
 
-    sqlite3_finalize(stmt);
+    release_statement(stmt);
     closeDatabase(db);
     if (query_copy) free(query_copy);
     if (query_copy2) free(query_copy2);
@@ -453,29 +459,7 @@ char discovery(struct Route *head, struct Route *destination, const char *queryS
         fprintf(stderr, "Failed to convert cJSON object to a JSON string\n");
         responseMessage(response, 500, "Internal Server Error", "Failed to convert cJSON object to a JSON string");
         // Cleanup
-        sqlite3_finalize(stmt);
-        closeDatabase(db);
-        if (query_copy) free(query_copy);
-        if (query_copy2) free(query_copy2);
-        if (MVconditions) sqlite3_free(MVconditions);
-        if (MTCconditions) sqlite3_free(MTCconditions);
-        if (query) sqlite3_free(query);
-        cJSON_Delete(root);
-        return FALSE;
-    }
-    char *response_data = json_str;
-    
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(response_data) + 1;
-    
-    // Allocate memory for the response buffer
-    *response = (char *)malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         if (query_copy) free(query_copy);
         if (query_copy2) free(query_copy2);
@@ -483,19 +467,18 @@ char discovery(struct Route *head, struct Route *destination, const char *queryS
         if (MTCconditions) sqlite3_free(MTCconditions);
         if (query) sqlite3_free(query);
         cJSON_Delete(root);
-        free(json_str);
         return FALSE;
     }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", response_data);
+    // The printed JSON is sent as the body and freed by the response
+    http_response_json(response, 200, "OK", json_str, cJSON_free);
 
     // Cleanup
     cJSON_Delete(root);
-    free(json_str);
 
     return TRUE;
 }
 
-char post_ae(struct Route** head, struct Route* destination, cJSON *content, char** response) {
+char post_ae(RouteTable *routes, struct Route* destination, cJSON *content, HTTPResponse *response) {
     
     // JSON Validation
     
@@ -607,7 +590,7 @@ char post_ae(struct Route** head, struct Route* destination, cJSON *content, cha
 
     // Append "/<rn value>" to ae->url
     sprintf(ae->url + destinationKeyLength, "/%s", cJSON_GetObjectItemCaseSensitive(content, "rn")->valuestring);
-    if (search(*head, ae->url) != NULL) {
+    if (search(routes, ae->url) != NULL) {
         responseMessage(response, 409, "Conflict", "Resource already exists (Skipping)");
         free(ae->url);
         free(ae);
@@ -641,7 +624,7 @@ char post_ae(struct Route** head, struct Route* destination, cJSON *content, cha
 
     // Add New Routes
     to_lowercase(uri);
-    addRoute(head, uri, ae->ri, ae->ty, ae->rn);
+    addRoute(routes, uri, ae->ri, ae->ty, ae->rn);
     printf("New Route: %s -> %s -> %d -> %s \n", uri, ae->ri, ae->ty, ae->rn);
 
     // Convert the AE struct to json and the Json Object to Json String
@@ -657,29 +640,11 @@ char post_ae(struct Route** head, struct Route* destination, cJSON *content, cha
         return FALSE;
     }
 
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(str) + 1;
-
-    // Allocate memory for the response buffer
-    *response = (char *)malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        cJSON_free(str);
-        cJSON_Delete(root);
-        free(ae->url);
-        free(ae);
-        pthread_mutex_unlock(&db_mutex);
-        pthread_mutex_destroy(&db_mutex);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", str);
+    // The printed JSON is sent as the body and freed by the response
+    http_response_json(response, 200, "OK", str, cJSON_free);
 
     // Free allocated resources
     cJSON_Delete(root);
-    cJSON_free(str);
 
     // // access database here
     pthread_mutex_unlock(&db_mutex);
@@ -694,7 +659,7 @@ char post_ae(struct Route** head, struct Route* destination, cJSON *content, cha
     return TRUE;
 }
 
-char post_cnt(struct Route** head, struct Route* destination, cJSON *content, char** response) {
+char post_cnt(RouteTable *routes, struct Route* destination, cJSON *content, HTTPResponse *response) {
     
     // JSON Validation
     
@@ -808,7 +773,7 @@ char post_cnt(struct Route** head, struct Route* destination, cJSON *content, ch
     // Append "/<rn value>" to cnt->url
     sprintf(cnt->url + destinationKeyLength, "/%s", cJSON_GetObjectItemCaseSensitive(content, "rn")->valuestring);
     to_lowercase(cnt->url);
-    if (search(*head, cnt->url) != NULL) {
+    if (search(routes, cnt->url) != NULL) {
         responseMessage(response, 409, "Conflict", "Resource already exists (Skipping)");
         return FALSE;
     }
@@ -823,7 +788,7 @@ char post_cnt(struct Route** head, struct Route* destination, cJSON *content, ch
     }
     
     // Add New Routes
-    addRoute(head, cnt->url, cnt->ri, cnt->ty, cnt->rn);
+    addRoute(routes, cnt->url, cnt->ri, cnt->ty, cnt->rn);
     printf("New Route: %s -> %s -> %d -> %s \n", cnt->url, cnt->ri, cnt->ty, cnt->rn);
 
     // Creating ol(dest) and la(test) routes
@@ -846,8 +811,8 @@ char post_cnt(struct Route** head, struct Route* destination, cJSON *content, ch
     sprintf(url_ol, "%s/ol", cnt->url);
     sprintf(url_la, "%s/la", cnt->url);
 
-    addRoute(head, url_ol, cnt->ri, CIN, "ol");
-    addRoute(head, url_la, cnt->ri, CIN, "la");
+    addRoute(routes, url_ol, cnt->ri, CIN, "ol");
+    addRoute(routes, url_la, cnt->ri, CIN, "la");
 
     // Convert the CNT struct to json and the Json Object to Json String
     cJSON *root = cnt_to_json(cnt);
@@ -860,25 +825,11 @@ char post_cnt(struct Route** head, struct Route* destination, cJSON *content, ch
         return FALSE;
     }
     
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(str) + 1;
-    
-    // Allocate memory for the response buffer
-    *response = (char *)malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        cJSON_free(str);
-        cJSON_Delete(root);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", str);
+    // The printed JSON is sent as the body and freed by the response
+    http_response_json(response, 200, "OK", str, cJSON_free);
 
     // Free allocated resources
     cJSON_Delete(root);
-    cJSON_free(str);
 
     // // access database here
     pthread_mutex_unlock(&db_mutex);
@@ -892,7 +843,7 @@ char post_cnt(struct Route** head, struct Route* destination, cJSON *content, ch
     return TRUE;
 }
 
-char post_cin(struct Route** head, struct Route* destination, cJSON *content, char** response) {
+char post_cin(RouteTable *routes, struct Route* destination, cJSON *content, HTTPResponse *response) {
     
     // JSON Validation
     
@@ -993,7 +944,7 @@ char post_cin(struct Route** head, struct Route* destination, cJSON *content, ch
     size_t rnLength = strlen(cJSON_GetObjectItemCaseSensitive(content, "rn")->valuestring);
 
     // Allocate memory for cin->url, considering the extra characters for "/", and the null terminator.
-    cin->url = (char *)malloc(destinationKeyLength + rnLength + 2);
+    cin->url = (char *)arena_alloc(destinationKeyLength + rnLength + 2);
 
     // Check if memory allocation is successful
     if (cin->url == NULL) {
@@ -1012,7 +963,7 @@ char post_cin(struct Route** head, struct Route* destination, cJSON *content, ch
     // Append "/<rn value>" to cin->url
     sprintf(cin->url + destinationKeyLength, "/%s", cJSON_GetObjectItemCaseSensitive(content, "rn")->valuestring);
     to_lowercase(cin->url);
-    if (search(*head, cin->url) != NULL) {
+    if (resolve_route(routes, cin->url) != NULL) {
         responseMessage(response, 409, "Conflict", "Resource already exists (Skipping)");
         return FALSE;
     }
@@ -1024,33 +975,26 @@ char post_cin(struct Route** head, struct Route* destination, cJSON *content, ch
         responseMessage(response, 500, "Internal Server Error", "Failed to initialize the database.");
         return FALSE;
     }
-    char *sql = sqlite3_mprintf("SELECT st FROM mtc WHERE LOWER(url) = LOWER('%s') AND et > datetime('now');", destination->key);
-    if (sql == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        return FALSE;
-    }
-    sqlite3_stmt *stmt;
-    short rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    sqlite3_stmt *stmt = prepare_statement(db, STMT_SELECT_CNT_ST);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, destination->key, -1, SQLITE_STATIC);
 
     // Populate the st attribute
-    rc = sqlite3_step(stmt);
+    short rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         cJSON_AddNumberToObject(content, "st", sqlite3_column_int(stmt, 0));
     } else {
         printf("Failed to step through the statement: %s\n", sqlite3_errmsg(db));
         responseMessage(response, 400, "Bad Request", "Failed to step through the statement.");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    release_statement(stmt);
 
     rs = create_cin(db, cin, content, response);
 
@@ -1061,8 +1005,8 @@ char post_cin(struct Route** head, struct Route* destination, cJSON *content, ch
         return FALSE;
     }
     
-    // Add New Routes
-    addRoute(head, cin->url, cin->ri, cin->ty, cin->rn);
+    // CINs are not kept in the route table, the new one goes to the route cache
+    route_cache_add(cin->url, cin->ri, cin->ty, cin->rn);
     printf("New Route: %s -> %s -> %d -> %s \n", uri, cin->ri, cin->ty, cin->rn);
     
     // Convert the CIN struct to json and the Json Object to Json String
@@ -1074,25 +1018,11 @@ char post_cin(struct Route** head, struct Route* destination, cJSON *content, ch
         return FALSE;
     }
     
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(str) + 1;
-    
-    // Allocate memory for the response buffer
-    *response = (char *)malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        cJSON_free(str);
-        cJSON_Delete(root);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", str);
+    // The printed JSON is sent as the body and freed by the response
+    http_response_json(response, 200, "OK", str, cJSON_free);
 
     // Free allocated resources
     cJSON_Delete(root);
-    cJSON_free(str);
 
     // // access database here
     pthread_mutex_unlock(&db_mutex);
@@ -1103,7 +1033,7 @@ char post_cin(struct Route** head, struct Route* destination, cJSON *content, ch
     return TRUE;
 }
 
-char post_sub(struct Route** head, struct Route* destination, cJSON *content, char** response) {
+char post_sub(RouteTable *routes, struct Route* destination, cJSON *content, HTTPResponse *response) {
     
     // JSON Validation
     
@@ -1214,7 +1144,7 @@ char post_sub(struct Route** head, struct Route* destination, cJSON *content, ch
     // Append "/<rn value>" to sub->url
     sprintf(sub->url + destinationKeyLength, "/%s", cJSON_GetObjectItemCaseSensitive(content, "rn")->valuestring);
     to_lowercase(sub->url);
-    if (search(*head, sub->url) != NULL) {
+    if (search(routes, sub->url) != NULL) {
         responseMessage(response, 409, "Conflict", "Resource already exists (Skipping)");
         return FALSE;
     }
@@ -1241,7 +1171,7 @@ char post_sub(struct Route** head, struct Route* destination, cJSON *content, ch
     }
     
     // Add New Routes
-    addRoute(head, sub->url, sub->ri, sub->ty, sub->rn);
+    addRoute(routes, sub->url, sub->ri, sub->ty, sub->rn);
     printf("New Route: %s -> %s -> %d -> %s \n", uri, sub->ri, sub->ty, sub->rn);
     
     // Convert the SUB struct to json and the Json Object to Json String
@@ -1253,25 +1183,11 @@ char post_sub(struct Route** head, struct Route* destination, cJSON *content, ch
         return FALSE;
     }
     
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(str) + 1;
-    
-    // Allocate memory for the response buffer
-    *response = (char *)malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        cJSON_free(str);
-        cJSON_Delete(root);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", str);
+    // The printed JSON is sent as the body and freed by the response
+    http_response_json(response, 200, "OK", str, cJSON_free);
 
     // Free allocated resources
     cJSON_Delete(root);
-    cJSON_free(str);
 
     // // access database here
     pthread_mutex_unlock(&db_mutex);
@@ -1282,7 +1198,7 @@ char post_sub(struct Route** head, struct Route* destination, cJSON *content, ch
     return TRUE;
 }
 
-char retrieve_cnt(struct Route * destination, char **response) {
+char retrieve_cnt(struct Route * destination, HTTPResponse *response) {
     pthread_mutex_t db_mutex;
     if (pthread_mutex_init(&db_mutex, NULL) != 0) {
          responseMessage(response, 500, "Internal Server Error", "Could not initialize the mutex");
@@ -1297,7 +1213,7 @@ char retrieve_cnt(struct Route * destination, char **response) {
     return TRUE;
 }
 
-char retrieve_ae(struct Route * destination, char **response) {
+char retrieve_ae(struct Route * destination, HTTPResponse *response) {
     pthread_mutex_t db_mutex;
     if (pthread_mutex_init(&db_mutex, NULL) != 0) {
          responseMessage(response, 500, "Internal Server Error", "Could not initialize the mutex");
@@ -1312,7 +1228,7 @@ char retrieve_ae(struct Route * destination, char **response) {
     return TRUE;
 }
 
-char retrieve_cin(struct Route * destination, char **response) {
+char retrieve_cin(struct Route * destination, HTTPResponse *response) {
     pthread_mutex_t db_mutex;
     if (pthread_mutex_init(&db_mutex, NULL) != 0) {
          responseMessage(response, 500, "Internal Server Error", "Could not initialize the mutex");
@@ -1327,7 +1243,7 @@ char retrieve_cin(struct Route * destination, char **response) {
     return TRUE;
 }
 
-char retrieve_sub(struct Route * destination, char **response) {
+char retrieve_sub(struct Route * destination, HTTPResponse *response) {
     pthread_mutex_t db_mutex;
     if (pthread_mutex_init(&db_mutex, NULL) != 0) {
          responseMessage(response, 500, "Internal Server Error", "Could not initialize the mutex");
@@ -1387,7 +1303,74 @@ char has_disallowed_keys(cJSON *json_object, const char **allowed_keys, size_t n
     return FALSE;
 }
 
-char delete_resource(struct Route * destination, char **response) {
+// Sends the event to every subscription of pi that asked for it, each one on its own thread
+void notify_subscribers(sqlite3 *db, const char *pi, const char *blob, const char *event) {
+    sqlite3_stmt *stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+    if (stmt == NULL) {
+        fprintf(stderr, "Failed to look up the subscribers of %s\n", pi);
+        return;
+    }
+    sqlite3_bind_text(stmt, 1, pi, -1, SQLITE_STATIC);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *enc_temp = (const char *)sqlite3_column_text(stmt, 2);
+        // Check if the subscription eventNotificationCriteria contains the event
+        if (enc_temp == NULL || strstr(enc_temp, event) == NULL) {
+            continue;
+        }
+
+        notificationData* data = malloc(sizeof(notificationData));
+        pthread_t thread_id;
+        int result;
+
+        const char *nu_temp = (const char *)sqlite3_column_text(stmt, 0);
+        data->nu = malloc(strlen(nu_temp) + 1); // +1 for null terminator
+        strcpy(data->nu, nu_temp);
+
+        const char *url_temp = (const char *)sqlite3_column_text(stmt, 1);
+        data->topic = malloc(strlen(url_temp) + 1); // +1 for null terminator
+        strcpy(data->topic, url_temp);
+
+        // Here we construct the prefix dynamically with sprintf. 
+        char prefix[256];  // Make sure this size is enough for your string
+        sprintf(prefix, "{\"m2m:sgn\":{\"cr\":\"admin:admin\",\"nev\":{\"net\":\"%s\",\"om\":null,\"rep\":", event);
+        char *suffix = "}}";
+
+        int total_length = strlen(prefix) + strlen(blob) + strlen(data->topic) + strlen(suffix) + 201;
+        // Allocate enough memory for the new string
+        char *wrapped_body = malloc(total_length);
+        if (wrapped_body == NULL) {
+            fprintf(stderr, "Failed to allocate memory for the wrapped body.\n");
+            free(data->nu); // Free the memory for the string
+            free(data->topic); // Free the memory for the string
+            free(data); // Then free the memory for the struct
+            continue;
+        }
+        // Start with the prefix
+        strcpy(wrapped_body, prefix);
+        // Append the original body
+        strcat(wrapped_body, blob);
+        // Append the topic
+        strcat(wrapped_body, ",\"nfu\":null,\"sud\":null,\"sur\":\"");
+        strcat(wrapped_body, data->topic);
+        strcat(wrapped_body, "\",\"vrq\":null}");
+        // Append the suffix
+        strcat(wrapped_body, suffix);
+        data->body = wrapped_body;
+
+        result = pthread_create(&thread_id, NULL, send_notification, data); //pass data, not &data
+        if (result != 0) {
+            fprintf(stderr, "Error creating thread: %s\n", strerror(result));
+            free(data->nu); // Free the memory for the string
+            free(data->topic); // Free the memory for the string
+            free(data->body); // Free the memory for the string
+            free(data); // Then free the memory for the struct
+        }
+    }
+    release_statement(stmt);
+}
+
+char delete_resource(RouteTable *routes, struct Route * destination, HTTPResponse *response) {
 
     char* errMsg = NULL;
 
@@ -1398,52 +1381,33 @@ char delete_resource(struct Route * destination, char **response) {
         return FALSE;
     }
 
-    char *sql_blob = sqlite3_mprintf("SELECT blob, pi FROM mtc WHERE LOWER(ri) = LOWER('%s') AND et > DATETIME('now');", destination->ri);
-    
-    if (sql_blob == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        return FALSE;
-    }
-    sqlite3_stmt *stmt;
-    short rc = sqlite3_prepare_v2(db, sql_blob, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    sqlite3_stmt *stmt = prepare_statement(db, STMT_SELECT_BLOB_BY_RI);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, destination->ri, -1, SQLITE_STATIC);
+    short rc;
     char *blob = NULL;
     char *pi = NULL;
     if (sqlite3_step(stmt) == SQLITE_ROW) {
-        blob = malloc(strlen((char *)sqlite3_column_text(stmt, 0)));
-        strcpy(blob, (char *)sqlite3_column_text(stmt, 0));
-        pi = malloc(strlen((char *)sqlite3_column_text(stmt, 1)));
+        if (destination->ty == CNT) {
+            blob = render_cnt((char *)sqlite3_column_text(stmt, 0), sqlite3_column_int(stmt, 2), sqlite3_column_int(stmt, 3));
+        } else {
+            blob = malloc(strlen((char *)sqlite3_column_text(stmt, 0)) + 1);
+            strcpy(blob, (char *)sqlite3_column_text(stmt, 0));
+        }
+        pi = malloc(strlen((char *)sqlite3_column_text(stmt, 1)) + 1);
         strcpy(pi, (char *)sqlite3_column_text(stmt, 1));
     } else {
         printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
         responseMessage(response, 400, "Bad Request", "Failed to find the resource.");
-        sqlite3_finalize(stmt);
-        closeDatabase(db);
-        return FALSE;
-    }
-
-    char *sql_not = sqlite3_mprintf("SELECT DISTINCT nu, url, enc as blob FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');", pi);
-    
-    if (sql_not == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        return FALSE;
-    }
-    rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
-        responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    release_statement(stmt);
 
     // Enable foreign keys
     char *sql = "PRAGMA foreign_keys=ON;";
@@ -1501,60 +1465,17 @@ char delete_resource(struct Route * destination, char **response) {
             }
         }
 
-        sqlite3_stmt *stmt;
-        int cni, cbs;
-        char *sql = sqlite3_mprintf("SELECT cni - 1, cbs - (SELECT cs FROM mtc WHERE ri = '%s'), blob FROM mtc WHERE LOWER(url) = LOWER('%s') AND et > datetime('now');", destination->ri, result);
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
-        sqlite3_free(sql);
-        if (rc != SQLITE_OK) {
-            fprintf(stderr,"Failed to execute statement: %s\n", sqlite3_errmsg(db));
-            responseMessage(response, 400, "Bad Request", "Verify the request body");
-            rollback_transaction(db); // Rollback transaction
-            sqlite3_finalize(stmt);
-            closeDatabase(db);
-            return FALSE;
-        }
-
-        cJSON *cntBlob = NULL;
-        if ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-            cni = sqlite3_column_int(stmt, 0);
-            cbs = sqlite3_column_int(stmt, 1);
-
-            cntBlob = cJSON_Parse((char *)sqlite3_column_text(stmt, 2));
-            cJSON *cnt = cJSON_GetObjectItem(cntBlob, "m2m:cnt");
-            if(cnt != NULL) {
-                cJSON *JsonCni = cJSON_GetObjectItem(cnt, "cni");
-                cJSON *JsonCbs = cJSON_GetObjectItem(cnt, "cbs");
-
-                if(JsonCni != NULL) {
-                    cJSON_ReplaceItemInObject(cnt, "cni", cJSON_CreateNumber(cni));
-                }
-
-                if(JsonCbs != NULL) {
-                    cJSON_ReplaceItemInObject(cnt, "cbs", cJSON_CreateNumber(cbs));
-                }
-            }
-        }
-
-        sqlite3_finalize(stmt);
-
-        // Update the parent container
-        const char *updateSql = "UPDATE mtc SET cni = ?, cbs = ?, blob = ? WHERE LOWER(url) = LOWER(?);";
-        
-        rc = sqlite3_prepare_v2(db, updateSql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
+        // Update the parent container, its blob gets the counters when it is read
+        sqlite3_stmt *stmt = prepare_statement(db, STMT_REMOVE_CNT_INSTANCE_BY_URL);
+        if (stmt == NULL) {
             free(result);
-            fprintf(stderr,"Failed to prepare statement: %s\n", sqlite3_errmsg(db));
-            sqlite3_finalize(stmt);
             responseMessage(response, 500, "Internal Server Error", "Could not update the CNT resource.");
+            rollback_transaction(db); // Rollback transaction
             closeDatabase(db);
             return FALSE;
         }
-
-        sqlite3_bind_int(stmt, 1, cni);
-        sqlite3_bind_int(stmt, 2, cbs);
-        sqlite3_bind_text(stmt, 3, cJSON_Print(cntBlob), strlen(cJSON_Print(cntBlob)), SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 4, result, strlen(result), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 1, destination->ri, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, result, -1, SQLITE_STATIC);
 
         rc = sqlite3_step(stmt);
         if (rc != SQLITE_DONE) {
@@ -1562,25 +1483,31 @@ char delete_resource(struct Route * destination, char **response) {
             fprintf(stderr,"Failed to execute statement: %s\n", sqlite3_errmsg(db));
             responseMessage(response, 500, "Internal Server Error", "Could not update the CNT resource.");
             rollback_transaction(db); // Rollback transaction
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             return FALSE;
         }
 
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         free(result);
     }
 
     // Delete record from SQLite3 table
-    char* sql_mtc = sqlite3_mprintf("DELETE FROM mtc WHERE ri='%q' AND et > datetime('now')", destination->ri);
-    int rs = sqlite3_exec(db, sql_mtc, NULL, NULL, &errMsg);
-    sqlite3_free(sql_mtc);
+    sqlite3_stmt *delete_stmt = prepare_statement(db, STMT_DELETE_BY_RI);
+    if (delete_stmt == NULL) {
+        responseMessage(response,400,"Bad Request","Error deleting record");
+        rollback_transaction(db); // Rollback transaction
+        closeDatabase(db);
+        return FALSE;
+    }
+    sqlite3_bind_text(delete_stmt, 1, destination->ri, -1, SQLITE_STATIC);
+    int rs = sqlite3_step(delete_stmt);
+    release_statement(delete_stmt);
 
-    if (rs != SQLITE_OK) {
+    if (rs != SQLITE_DONE) {
         responseMessage(response,400,"Bad Request","Error deleting record");
-        fprintf(stderr, "Error deleting record: %s\n", errMsg);
+        fprintf(stderr, "Error deleting record: %s\n", sqlite3_errmsg(db));
         rollback_transaction(db); // Rollback transaction
-        sqlite3_free(errMsg);
         closeDatabase(db);
         return FALSE;
     }
@@ -1596,130 +1523,25 @@ char delete_resource(struct Route * destination, char **response) {
 
     printf("Resource deleted from the database\n");
 
-    // Imagina que é a primeira
-    // Imagina que é a ultima
-    // Imagina que é do meio
-    // deleteRoute(); {
-    // Remove node from ordered list
-
-    char *resourcePath = destination->key;
-    
-    struct Route *currentNode = destination->right;
-
-    // Handle cases where the node to delete is the first or the last node.
-    if (destination->left != NULL) {
-        destination->left->right = destination->right;
-    }
-
-    if (destination->right != NULL) {
-        destination->right->left = destination->left;
-    }
-
-    while (currentNode != NULL && strncmp(currentNode->key, resourcePath, strlen(resourcePath)) == 0) {
-        printf("Deleting currentNode->key = %s\n", currentNode->key);
-
-        // We need to store the reference of the right node before freeing the current node.
-        struct Route *nextNode = currentNode->right;
-
-        // Again, handle cases where the node to delete is the first or the last node.
-        if (currentNode->left != NULL) {
-            currentNode->left->right = nextNode;
-        }
-
-        // printf("Deleting currentNode->key = %s\n", currentNode->key);
-        if (nextNode != NULL) {
-            nextNode->left = currentNode->left;
-        }
-
-        // free(currentNode);  // Free the memory of the deleted node.
-        
-        currentNode = nextNode;
-    }
-
+    // Drop the routes of the resource and everything below it
     printf("Record deleted ri = %s\n", destination->ri);
-    free(destination);  // Don't forget to free the memory of the deleted node.
+    if (search(routes, destination->key) == destination) {
+        route_cache_remove_below(destination->key);
+        remove_subtree(routes, destination);
+    } else {
+        route_cache_remove(destination->key);
+    }
     responseMessage(response,200,"OK","Record deleted");
     
-    // Populate the CNT
-    pthread_t thread_id;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        notificationData* data = malloc(sizeof(notificationData));
-        pthread_t thread_id;
-        int result;
-
-        const char *nu_temp = (const char *)sqlite3_column_text(stmt, 0);
-        data->nu = malloc(strlen(nu_temp) + 1); // +1 for null terminator
-        strcpy(data->nu, nu_temp);
-
-        const char *url_temp = (const char *)sqlite3_column_text(stmt, 1);
-        data->topic = malloc(strlen(url_temp) + 1); // +1 for null terminator
-        strcpy(data->topic, url_temp);
-
-        data->body = malloc(strlen(blob) + 1); // +1 for null terminator
-        strcpy(data->body, blob);
-
-        const char *enc_temp = (const char *)sqlite3_column_text(stmt, 2);
-        // Check if the subscription eventNotificationCriteria contains "POST"
-        if (strstr(enc_temp, "DELETE") == NULL) {
-            continue;
-        }
-
-        char *suffix = "}}";
-
-        int suffix_length = strlen(suffix);
-        int body_length = strlen(data->body);
-        int enc_temp_length = strlen(enc_temp); // assuming enc_temp is a string
-        int topic_length = strlen(data->topic);
-
-        // Here we construct the prefix dynamically with sprintf. 
-        char prefix[256];  // Make sure this size is enough for your string
-        sprintf(prefix, "{\"m2m:sgn\":{\"cr\":\"admin:admin\",\"nev\":{\"net\":\"%s\",\"om\":null,\"rep\":", "DELETE");
-        
-        int prefix_length = strlen(prefix);
-        int total_length = prefix_length + body_length + enc_temp_length + topic_length + strlen(suffix) + 201;
-        // Allocate enough memory for the new string
-        char *wrapped_body = malloc(total_length);
-
-        if(wrapped_body == NULL) {
-            fprintf(stderr, "Failed to allocate memory for the wrapped body.\n");
-            free(data->nu); // Free the memory for the string
-            free(data->topic); // Free the memory for the string
-            free(data->body); // Free the memory for the string
-            free(data); // Then free the memory for the struct
-            continue;
-        } else {
-            // Start with the prefix
-            strcpy(wrapped_body, prefix);
-            // Append the original body
-            strcat(wrapped_body, data->body);
-            // Append the topic
-            strcat(wrapped_body, ",\"nfu\":null,\"sud\":null,\"sur\":\"");
-            strcat(wrapped_body, data->topic);
-            strcat(wrapped_body, "\",\"vrq\":null}");
-            // Append the suffix
-            strcat(wrapped_body, suffix);
-
-            // Free the original body now that it's not needed
-            free(data->body);
-            // Make the wrapped body the new body
-            data->body = wrapped_body;
-        }
-
-        result = pthread_create(&thread_id, NULL, send_notification, data); //pass data, not &data
-        if (result != 0) {
-            fprintf(stderr, "Error creating thread: %s\n", strerror(result));
-            free(data->nu); // Free the memory for the string
-            free(data->topic); // Free the memory for the string
-            free(data->body); // Free the memory for the string
-            free(data); // Then free the memory for the struct
-        }
-    }
+    notify_subscribers(db, pi, blob, "DELETE");
+    free(blob);
+    free(pi);
 
     closeDatabase(db);
     return TRUE;
 }
 
-char put_cnt(struct Route* destination, cJSON *content, char** response) {
+char put_cnt(struct Route* destination, cJSON *content, HTTPResponse *response) {
 
     const char *allowed_keys[] = {"et", "acpi", "lbl", "daci", "ch", "aa", "at", "mbs", "mni", "mia", "or", "dr"};
 	size_t num_allowed_keys = sizeof(allowed_keys) / sizeof(allowed_keys[0]);
@@ -1746,7 +1568,7 @@ char put_cnt(struct Route* destination, cJSON *content, char** response) {
 	return TRUE;
 }
 
-char put_ae(struct Route* destination, cJSON *content, char** response) {
+char put_ae(struct Route* destination, cJSON *content, HTTPResponse *response) {
 
     const char *allowed_keys[] = {"rr", "et", "apn","nl", "or", "acpi", "lbl", "daci", "poa", "ch", "aa", "csz", "at"};
 	size_t num_allowed_keys = sizeof(allowed_keys) / sizeof(allowed_keys[0]);
@@ -1773,7 +1595,7 @@ char put_ae(struct Route* destination, cJSON *content, char** response) {
 	return TRUE;
 }
 
-char put_sub(struct Route* destination, cJSON *content, char** response) {
+char put_sub(struct Route* destination, cJSON *content, HTTPResponse *response) {
 
     const char *allowed_keys[] = {"et", "acpi", "lbl", "daci", "nu", "enc"};
 	size_t num_allowed_keys = sizeof(allowed_keys) / sizeof(allowed_keys[0]);
@@ -0,0 +1,178 @@
+/*
+ * Created on Thu Oct 15 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "Common.h"
+#include "mongoose.h"
+#include "Mongoose_Server.h"
+
+extern int RETRY_AFTER;
+extern int LISTEN_BACKLOG;
+extern int MAX_REQUEST_SIZE;
+
+// Queues the response, Mongoose copies it into its send buffer
+static void send_response(struct mg_connection *c, HTTPResponse *response, char keep_alive) {
+    char head[HTTP_RESPONSE_HEAD_SIZE];
+    size_t head_length = http_response_head(response, head, sizeof(head), keep_alive);
+    if (head_length == 0) {
+        keep_alive = FALSE;
+    } else {
+        mg_send(c, head, head_length);
+        for (int i = 0; i < response->num_slices; i++) {
+            mg_send(c, response->slices[i].data, response->slices[i].length);
+        }
+    }
+    if (keep_alive == FALSE) {
+        c->is_draining = 1;
+    }
+}
+
+// Mongoose calls us with the read before its HTTP handler parses the buffer,
+// so the buffer starts at the next request to be handled. Its head tells its
+// size up front, a chunked one is stopped once the buffer grows past the limit.
+static char request_too_large(struct mg_connection *c) {
+    size_t max_size = MAX_REQUEST_SIZE > HTTP_MAX_HEAD_SIZE ? (size_t) MAX_REQUEST_SIZE : HTTP_MAX_HEAD_SIZE;
+    if (c->recv.len > max_size) {
+        return TRUE;
+    }
+    struct mg_http_message hm;
+    int head_length = mg_http_parse((char *) c->recv.buf, c->recv.len, &hm);
+    return head_length > 0 && hm.body.len != (size_t) ~0 && hm.body.len > max_size - (size_t) head_length;
+}
+
+static void fn_server(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    // Same connection budget as the native server, there is no worker queue to bound here
+    if (ev == MG_EV_ACCEPT) {
+        if (admission_connection_open() == FALSE) {
+            mg_printf(c, "HTTP/1.1 503 Service Unavailable\r\nRetry-After: %d\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", RETRY_AFTER);
+            c->is_draining = 1;
+        }
+        return;
+    } else if (ev == MG_EV_CLOSE) {
+        if (c->is_accepted) {
+            admission_connection_closed();
+        }
+        return;
+    } else if (ev == MG_EV_READ) {
+        // Mongoose keeps reading draining connections, drop what they send so
+        // refused or closing connections never reach the handlers
+        if (c->is_draining) {
+            c->recv.len = 0;
+            return;
+        }
+        if (c->is_accepted && request_too_large(c)) {
+            HTTPResponse response;
+            http_response_init(&response);
+            responseMessage(&response, 413, "Payload Too Large", "Request is too large");
+            send_response(c, &response, FALSE);
+            http_response_reset(&response);
+            c->recv.len = 0;
+        }
+        return;
+    } else if (ev != MG_EV_HTTP_MSG) {
+        return;
+    }
+    if (c->is_draining) {
+        c->recv.len = 0;
+        return;
+    }
+    struct mg_http_message *hm = (struct mg_http_message *) ev_data;
+
+    // The handlers want NUL terminated, writable strings: method, path and query
+    // are copied side by side, the body is passed straight from Mongoose's buffer
+    char *strings = malloc(hm->method.len + hm->uri.len + hm->query.len + 3);
+    if (strings == NULL) {
+        fprintf(stderr, "Failed to allocate memory for the request line\n");
+        mg_http_reply(c, 500, "", "");
+        return;
+    }
+    char *method = strings;
+    char *urlRoute = method + hm->method.len + 1;
+    char *queryString = urlRoute + hm->uri.len + 1;
+    memcpy(method, hm->method.ptr, hm->method.len);
+    method[hm->method.len] = '\0';
+    memcpy(urlRoute, hm->uri.ptr, hm->uri.len);
+    urlRoute[hm->uri.len] = '\0';
+    memcpy(queryString, hm->query.ptr, hm->query.len);
+    queryString[hm->query.len] = '\0';
+
+    ConnectionInfo info;
+    memset(&info, 0, sizeof(ConnectionInfo));
+    info.socket_desc = -1;
+    info.routes = (struct RouteTable *) fn_data;
+
+    char *if_none_match = NULL;
+    struct mg_str *etag = mg_http_get_header(hm, "If-None-Match");
+    if (etag != NULL) {
+        if_none_match = malloc(etag->len + 1);
+        if (if_none_match != NULL) {
+            memcpy(if_none_match, etag->ptr, etag->len);
+            if_none_match[etag->len] = '\0';
+        }
+    }
+
+    arena_begin();
+    epoch_enter();
+    HTTPResponse response;
+    http_response_init(&response);
+    dispatch_request(&info, method, urlRoute, queryString, hm->body.ptr, hm->body.len, if_none_match, &response);
+    free(strings);
+    free(if_none_match);
+
+    // Same keep-alive rules as the native server
+    char keep_alive = mg_vcmp(&hm->proto, "HTTP/1.1") == 0 ? TRUE : FALSE;
+    struct mg_str *connection = mg_http_get_header(hm, "Connection");
+    if (connection != NULL) {
+        if (mg_vcasecmp(connection, "close") == 0) {
+            keep_alive = FALSE;
+        } else if (mg_vcasecmp(connection, "keep-alive") == 0) {
+            keep_alive = TRUE;
+        }
+    }
+
+    // The slices are released right after they are queued
+    send_response(c, &response, keep_alive);
+    http_response_reset(&response);
+    epoch_exit();
+    arena_end();
+
+    // The whole response is queued, let Mongoose parse the next pipelined request
+    c->is_resp = 0;
+}
+
+char run_mongoose_server(int port, struct RouteTable *routes) {
+    struct mg_mgr mgr;
+    char url[64];
+    snprintf(url, sizeof(url), "http://0.0.0.0:%d", port);
+
+    mg_mgr_init(&mgr);
+    struct mg_connection *listener = mg_http_listen(&mgr, url, fn_server, routes);
+    if (listener == NULL) {
+        fprintf(stderr, "Failed to listen on %s\n", url);
+        mg_mgr_free(&mgr);
+        return FALSE;
+    }
+    // Mongoose listens with a backlog of 3, connections past it get reset under
+    // load. Listening again on the socket only changes the backlog.
+    if (listen((int) (size_t) listener->fd, LISTEN_BACKLOG) < 0) {
+        perror("listen");
+    }
+
+    printf("HTTP Server Initialized (mongoose)\nPort: %d\n", port);
+    while (TRUE) {
+        mg_mgr_poll(&mgr, MONGOOSE_POLL_MS);
+    }
+
+    mg_mgr_free(&mgr);
+    return TRUE;
+}
@@ -0,0 +1,234 @@
+/*
+ * Created on Mon Oct 12 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "Common.h"
+
+static char set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+extern int KEEPALIVE_TIMEOUT;
+extern int HEADER_TIMEOUT;
+extern int BODY_TIMEOUT;
+
+// Between requests a connection gets the keep-alive timeout. A request that is
+// still arriving gets the header timeout from its first byte, then the body
+// timeout from the end of its head, so trickling bytes does not extend either.
+static time_t connection_deadline(ConnectionInfo *info, time_t now) {
+    if (info->buffer_len == 0) {
+        info->request_started = 0;
+        info->body_started = 0;
+        return now + KEEPALIVE_TIMEOUT;
+    }
+    if (info->request_started == 0) {
+        info->request_started = now;
+    }
+    if (info->request.state == HTTP_STATE_HEAD) {
+        return info->request_started + HEADER_TIMEOUT;
+    }
+    if (info->body_started == 0) {
+        info->body_started = now;
+    }
+    return info->body_started + BODY_TIMEOUT;
+}
+
+// Called by the wheel with reactor->lock held
+static void connection_expired(TimerNode *node, void *arg) {
+    Reactor *reactor = (Reactor *) arg;
+    ConnectionInfo *info = (ConnectionInfo *) ((char *) node - offsetof(ConnectionInfo, timer));
+
+    epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, info->socket_desc, NULL);
+    // A request was cut short, tell the client why before closing
+    if (info->buffer_len > 0) {
+        const char *message = "HTTP/1.1 408 Request Timeout\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        send(info->socket_desc, message, strlen(message), MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+    close_connection(info);
+}
+
+// Closes the connections whose deadline passed. Only the slots of the seconds
+// elapsed since the last sweep are visited, not every waiting connection.
+static void sweep_timers(Reactor *reactor) {
+    pthread_mutex_lock(&reactor->lock);
+    timer_wheel_expire(&reactor->timers, time(NULL), connection_expired, reactor);
+    pthread_mutex_unlock(&reactor->lock);
+}
+
+static void accept_clients(Reactor *reactor) {
+    // The listening socket is non-blocking, drain every pending connection
+    while (TRUE) {
+        // Workers drain the socket until EAGAIN, so it must never block them
+        int client_socket = accept4(reactor->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("accept failed");
+            }
+            return;
+        }
+
+        // Over the connection budget: answer 503 now rather than queue the client
+        if (admission_connection_open() == FALSE) {
+            admission_reject(client_socket);
+            close(client_socket);
+            admission_connection_closed();
+            continue;
+        }
+
+        ConnectionInfo *info = malloc(sizeof(ConnectionInfo));
+        if (info == NULL) {
+            perror("malloc failed");
+            close(client_socket);
+            admission_connection_closed();
+            continue;
+        }
+        memset(info, 0, sizeof(ConnectionInfo));
+        timer_node_init(&info->timer);
+        info->socket_desc = client_socket;
+        info->routes = reactor->routes;
+        info->reactor = reactor;
+
+        configure_client_socket(client_socket);
+
+        // One-shot: a connection is either watched here or owned by a worker, never both
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+        event.data.ptr = info;
+
+        pthread_mutex_lock(&reactor->lock);
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, client_socket, &event) < 0) {
+            pthread_mutex_unlock(&reactor->lock);
+            perror("epoll_ctl");
+            close_connection(info);
+            continue;
+        }
+        timer_wheel_add(&reactor->timers, &info->timer, connection_deadline(info, time(NULL)));
+        pthread_mutex_unlock(&reactor->lock);
+    }
+}
+
+static void *reactor_loop(void *arg) {
+    Reactor *reactor = (Reactor *) arg;
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    while (TRUE) {
+        int n = epoll_wait(reactor->epoll_fd, events, REACTOR_MAX_EVENTS, REACTOR_SWEEP_MS);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == NULL) {
+                accept_clients(reactor);
+                continue;
+            }
+
+            // The one-shot registration is disarmed now, the worker re-arms it when done
+            ConnectionInfo *info = (ConnectionInfo *) events[i].data.ptr;
+            pthread_mutex_lock(&reactor->lock);
+            timer_wheel_remove(&reactor->timers, &info->timer);
+            pthread_mutex_unlock(&reactor->lock);
+
+            // The reactor never waits for the pool: past the in-flight budget or
+            // with the queue full the client is shed with a 503
+            if (admission_request_begin() == FALSE) {
+                epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, info->socket_desc, NULL);
+                admission_reject(info->socket_desc);
+                close_connection(info);
+            } else if (worker_pool_try_submit(reactor->pool, handle_connection, info) == FALSE) {
+                admission_request_started();
+                admission_request_end();
+                epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, info->socket_desc, NULL);
+                admission_reject(info->socket_desc);
+                close_connection(info);
+            }
+        }
+
+        sweep_timers(reactor);
+    }
+
+    return NULL;
+}
+
+char init_reactor(Reactor *reactor, int listen_fd, WorkerPool *pool, struct RouteTable *routes) {
+    reactor->listen_fd = listen_fd;
+    reactor->pool = pool;
+    reactor->routes = routes;
+    init_timer_wheel(&reactor->timers, time(NULL));
+    pthread_mutex_init(&reactor->lock, NULL);
+
+    if (set_nonblocking(listen_fd) == FALSE) {
+        perror("fcntl");
+        return FALSE;
+    }
+
+    reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epoll_fd < 0) {
+        perror("epoll_create1");
+        return FALSE;
+    }
+
+    // The listening socket is registered with a NULL pointer to tell it apart from clients
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) < 0) {
+        perror("epoll_ctl");
+        close(reactor->epoll_fd);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+char start_reactor(Reactor *reactor) {
+    if (pthread_create(&reactor->thread, NULL, reactor_loop, reactor) != 0) {
+        perror("pthread_create failed");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Hands a connection back to epoll once a worker has answered everything it had buffered
+void reactor_rearm(Reactor *reactor, ConnectionInfo *info) {
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.ptr = info;
+
+    // The lock keeps the sweep from expiring the connection before it is re-armed
+    pthread_mutex_lock(&reactor->lock);
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_MOD, info->socket_desc, &event) < 0) {
+        pthread_mutex_unlock(&reactor->lock);
+        perror("epoll_ctl");
+        close_connection(info);
+        return;
+    }
+    timer_wheel_add(&reactor->timers, &info->timer, connection_deadline(info, time(NULL)));
+    pthread_mutex_unlock(&reactor->lock);
+}
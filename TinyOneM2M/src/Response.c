@@ -11,6 +11,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/socket.h>
+#include <strings.h>
+#include <errno.h>
 #include <pthread.h>
 #include "sqlite3.h"
 #include <unistd.h>
@@ -19,59 +21,40 @@
 #include "Common.h"
 
 extern char BASE_RI[MAX_CONFIG_LINE_LENGTH];
+extern int MAX_REQUEST_SIZE;
 
-char * render_static_file(char * fileName) {
-	FILE* file = fopen(fileName, "r");
-
-	if (file == NULL) {
-		return NULL;
-	}else {
-		printf("%s does exist \n", fileName);
-	}
-
-	fseek(file, 0, SEEK_END);
-	long fsize = ftell(file);
-	fseek(file, 0, SEEK_SET);
-
-	char* temp = malloc(sizeof(char) * (fsize+1));
-	char ch;
-	int i = 0;
-	while((ch = fgetc(file)) != EOF) {
-		temp[i] = ch;
-		i++;
-	}
-	fclose(file);
-	return temp;
-}
-
-void responseMessage(char** response, int status_code, char* status_message, char* message) {
+void responseMessage(HTTPResponse *response, int status_code, char* status_message, char* message) {
     printf("Creating the json response\n");
 
-    // Calculate the required response size
-    size_t response_size = snprintf(NULL, 0, "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n\r\n{\"status_code\": %d, \"message\":\"%s\"}", status_code, status_message, status_code, message) + 1;
+    // Calculate the required body size
+    size_t body_size = snprintf(NULL, 0, "{\"status_code\": %d, \"message\":\"%s\"}", status_code, message) + 1;
 
-    // Allocate memory for the response
-    *response = (char *)malloc(response_size * sizeof(char));
-    if (*response == NULL) {
+    // Allocate memory for the body, the response takes ownership of it
+    char *body = (char *)malloc(body_size * sizeof(char));
+    if (body == NULL) {
         // Handle memory allocation error
         fprintf(stderr, "Memory allocation error\n");
+        http_response_reset(response);
+        http_response_status(response, status_code, status_message, NULL);
         return;
     }
 
-    // Fill in the response buffer
-    sprintf(*response, "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n\r\n{\"status_code\": %d, \"message\":\"%s\"}", status_code, status_message, status_code, message);
+    // Fill in the body
+    sprintf(body, "{\"status_code\": %d, \"message\":\"%s\"}", status_code, message);
+    http_response_json(response, status_code, status_message, body, free);
 }
 
-void close_socket_and_exit(ConnectionInfo *info) {
+void close_connection(ConnectionInfo *info) {
     close(info->socket_desc);
+    free(info->buffer);
     free(info);
-    pthread_exit(NULL);
+    admission_connection_closed();
 }
 
-void handle_get(ConnectionInfo *info, const char *queryString, struct Route *destination, char **response) {
+void handle_get(ConnectionInfo *info, const char *queryString, struct Route *destination, HTTPResponse *response) {
 	
 	if (queryString != NULL && strlen(queryString) > 0 && strstr(queryString, "fu=1") != NULL) {
-		char rs = discovery(info->route, destination, queryString, response);
+		char rs = discovery(info->routes, destination, queryString, response);
 		if (rs == FALSE) {
 			responseMessage(response,500,"Internal Server Error","Error retrieving the data");
 			fprintf(stderr,"Could not discover resource\n");
@@ -124,8 +107,8 @@ void handle_get(ConnectionInfo *info, const char *queryString, struct Route *des
 	}
 }
 
-void handle_post(ConnectionInfo *info, const char *request, struct Route *destination, char **response) {
-	cJSON *json_object = get_json_from_request(request);
+void handle_post(ConnectionInfo *info, const char *body, size_t body_length, struct Route *destination, HTTPResponse *response) {
+	cJSON *json_object = get_json_from_request(body, body_length);
 
 	if (json_object == NULL) {
         responseMessage(response, 400, "Bad Request", "Invalid request body");
@@ -195,9 +178,14 @@ void handle_post(ConnectionInfo *info, const char *request, struct Route *destin
 						return;
 					}
 
+					// CINs are not in the route table, everything else changes it
+					char structural = ty != CIN;
+					if (structural) {
+						route_change_begin(info->routes);
+					}
 					switch (ty) {
 					case AE: {
-						char rs = post_ae(&info->route, destination, content, response);
+						char rs = post_ae(info->routes, destination, content, response);
 						if (rs == FALSE) {
 							// The method it self already change the response properly
 							fprintf(stderr, "Could not create AE resource\n");
@@ -205,7 +193,7 @@ void handle_post(ConnectionInfo *info, const char *request, struct Route *destin
 						break;
 					}
 					case CNT: {
-						char rs = post_cnt(&info->route, destination, content, response);
+						char rs = post_cnt(info->routes, destination, content, response);
 						if (rs == FALSE) {
 							// The method it self already change the response properly
 							fprintf(stderr, "Could not create CNT resource\n");
@@ -213,7 +201,7 @@ void handle_post(ConnectionInfo *info, const char *request, struct Route *destin
 						break;
 					}
 					case CIN: {
-						char rs = post_cin(&info->route, destination, content, response);
+						char rs = post_cin(info->routes, destination, content, response);
 						if (rs == FALSE) {
 							// The method it self already change the response properly
 							fprintf(stderr, "Could not create CIN resource\n");
@@ -221,7 +209,7 @@ void handle_post(ConnectionInfo *info, const char *request, struct Route *destin
 						break;
 					}
 					case SUB: {
-						char rs = post_sub(&info->route, destination, content, response);
+						char rs = post_sub(info->routes, destination, content, response);
 						if (rs == FALSE) {
 							// The method it self already change the response properly
 							fprintf(stderr, "Could not create SUB resource\n");
@@ -233,6 +221,9 @@ void handle_post(ConnectionInfo *info, const char *request, struct Route *destin
 						fprintf(stderr, "Theres no available resource for %s\n", key);
 						break;
 					}
+					if (structural) {
+						route_change_end(info->routes);
+					}
 				}
 			} else if (ret == REG_NOMATCH) {
 				responseMessage(response,400,"Bad Request","Invalid json root name, should match m2m:<resource> (e.g m2m:ae)");
@@ -250,27 +241,26 @@ void handle_post(ConnectionInfo *info, const char *request, struct Route *destin
 	}
 }
 
-void handle_delete(ConnectionInfo *info, struct Route *destination, char **response) {
+void handle_delete(ConnectionInfo *info, struct Route *destination, HTTPResponse *response) {
 	if (strcmp(destination->ri, BASE_RI) == 0) {
 		responseMessage(response,400,"Bad Request","Invalid resource.");
 		fprintf(stderr, "Could not delete CSEBASE resource.\n");
 		return;
 	}
 	
-	delete_resource(destination, response);
+	char structural = search(info->routes, destination->key) == destination;
+	if (structural) {
+		route_change_begin(info->routes);
+	}
+	delete_resource(info->routes, destination, response);
+	if (structural) {
+		route_change_end(info->routes);
+	}
 }
 
-void handle_put(ConnectionInfo *info, const char *request, struct Route *destination, char **response) {
-    char* json_start = strstr(request, "{"); // find the start of the JSON data
-	if (json_start != NULL) {
-		size_t json_length = strlen(json_start); // calculate the length of the JSON data
-		char json_data[json_length + 1]; // create a buffer to hold the JSON data
-		strncpy(json_data, json_start, json_length); // copy the JSON data to the buffer
-		json_data[json_length] = '\0'; // add a null terminator to the end of the buffer
-
-		// Parse the JSON string into a cJSON object
-		cJSON* json_object = cJSON_Parse(json_data);
-
+void handle_put(ConnectionInfo *info, const char *body, size_t body_length, struct Route *destination, HTTPResponse *response) {
+	cJSON* json_object = get_json_from_request(body, body_length);
+	if (json_object != NULL) {
 		// Retrieve the first key-value pair in the object
 		cJSON* first = json_object->child;
 		if (first != NULL) {
@@ -357,202 +347,212 @@ void handle_put(ConnectionInfo *info, const char *request, struct Route *destina
 	}
 }
 
-void *handle_connection(void *connectioninfo) {
-    ConnectionInfo* info = (ConnectionInfo*) connectioninfo;
-
-    char *response = NULL;
-
-	// Initializing the process of reading from the socket
-	char *buffer = NULL;
-	size_t buffer_size = INITIAL_BUFFER_SIZE;
-	size_t total_read = 0; // Variable that will hold the number of chars readed
-	ssize_t valread;
-
-	buffer = malloc(buffer_size);
-	if (buffer == NULL) {
-		responseMessage(&response, 500, "Internal Server Error", "Something Went Wrong.");
-		send(info->socket_desc, response, strlen(response), 0);
-		close_socket_and_exit(info);
-		free(response);
-	}
-
-	// Read the request data from the socket and increment the size of the buffer since it reaches the base-line size.
-	while (1) {
-		// Ensure there is enough space for the next chunk of data
-		if (total_read + BUFFER_INCREMENT_SIZE > buffer_size) {
-			buffer_size += BUFFER_INCREMENT_SIZE;
-			char *new_buffer = realloc(buffer, buffer_size);
-			if (new_buffer == NULL) {
-				perror("realloc");
-				free(buffer);
-				close_socket_and_exit(info);
-				return NULL;
-			}
-			buffer = new_buffer;
-		}
-
-		// Read data from the client
-		// valread holds the number of chars readed at once
-		// increment the buffer
-		valread = read(info->socket_desc, buffer + total_read, BUFFER_INCREMENT_SIZE);
-		if (valread < 0) {
-			perror("read");
-			free(buffer);
-			close_socket_and_exit(info);
-			return NULL;
-		} else if (valread < BUFFER_INCREMENT_SIZE) {
-			// No more data to read
-			total_read += valread;
-			break;
-		}
-
-		total_read += valread;
-	}
-
-	// Null-terminate the buffer
-	buffer[total_read] = '\0';
-
+// Routes one request to its handler. Shared by both server modes, so path and
+// query must be NUL terminated and writable (they are lowercased in place).
+void dispatch_request(ConnectionInfo *info, char *method, char *urlRoute, char *queryString, const char *body, size_t body_length, const char *if_none_match, HTTPResponse *response) {
     printf("\n");
 
-	total_read++;
-    char request[total_read];
-    strncpy(request, buffer, sizeof(request) - 1);
-    request[sizeof(request) - 1] = '\0';
-
-    // parsing client socket header to get HTTP method, route
-    char *method = "";
-    char *urlRoute = "";
-
-    char *client_http_header = strtok(buffer, "\n");
-
-    char *header_token = strtok(client_http_header, " ");
-
-    int header_parse_counter = 0;
-
-    while (header_token != NULL) {
-        switch (header_parse_counter) {
-            case 0:
-                method = header_token;
-                break;
-            case 1:
-                urlRoute = header_token;
-                break;
-        }
-        header_token = strtok(NULL, " ");
-        header_parse_counter++;
-    }
-
     to_lowercase(urlRoute);
-
-    char *queryString = strtok(urlRoute, "?");
-
-    urlRoute = queryString;
-    queryString = strtok(NULL, "?");
+    to_lowercase(queryString);
 
     printf("The method is %s\n", method);
     printf("The route is %s\n", urlRoute);
-    if (queryString != NULL && strcmp(queryString, "") != 0) {
+    if (strcmp(queryString, "") != 0) {
         printf("The query string is %s\n", queryString);
     }
 
-    struct Route *destination = search(info->route, urlRoute);
+    if (strcmp(urlRoute, ADMISSION_STATUS_ROUTE) == 0) {
+        if (strcmp(method, "GET") != 0) {
+            responseMessage(response, 405, "Method Not Allowed", "Method not allowed");
+            return;
+        }
+        admission_status(response);
+        return;
+    }
+
+    // Files under static/ are served straight from the cache loaded at startup
+    if (strncmp(urlRoute, STATIC_ASSETS_PREFIX, strlen(STATIC_ASSETS_PREFIX)) == 0) {
+        const StaticAsset *asset = static_cache_find(urlRoute);
+        if (asset == NULL) {
+            responseMessage(response, 404, "Not found", "Resource not found");
+        } else {
+            serve_static_asset(asset, if_none_match, response);
+        }
+        return;
+    }
+
+    struct Route *destination = resolve_route(info->routes, urlRoute);
+    if (destination == NULL && strchr(urlRoute + 1, '/') == NULL) {
+        // Unstructured addressing, /<ri> instead of the resource path
+        destination = resolve_ri(info->routes, urlRoute + 1);
+    }
 
     printf("Check if route was found\n");
     if (destination == NULL) {
-        responseMessage(&response, 404, "Not found", "Resource not found");
-        printf("http_header: %s\n", response);
-        goto cleanup;
+        responseMessage(response, 404, "Not found", "Resource not found");
+        printf("http_header: %s\n", response->status_line);
+        return;
     }
 
     // Creating the response
     printf("Check if it is the default route\n");
     if (destination->ty == -1) {
-        char template[100] = "templates/";
-        strncat(template, destination->value, sizeof(template) - strlen(template) - 1);
-        char *response_data = render_static_file(template);
-
-        FILE *file;
-        long file_size;
-
-        // Open the file in binary mode
-        file = fopen(template, "rb");
-
-        if (file == NULL) {
-            fprintf(stderr, "Failed to open the file.\n");
-            responseMessage(&response, 500, "Internal", "HTTP method not supported");
-            send(info->socket_desc, response, strlen(response), 0);
-            goto cleanup;
+        const StaticAsset *asset = static_cache_find(destination->value);
+        if (asset == NULL) {
+            fprintf(stderr, "Template %s is not loaded.\n", destination->value);
+            responseMessage(response, 500, "Internal", "HTTP method not supported");
+            return;
         }
-
-        // Get the size of the file
-        fseek(file, 0, SEEK_END);
-        file_size = ftell(file);
-        rewind(file);
-
-        // Close the file
-        fclose(file);
-
-        // Dynamically allocate memory for the buffer
-        response = (char *)malloc((file_size + 200) * sizeof(char));
-        if (response == NULL) {
-            fprintf(stderr, "Memory allocation failed.\n");
-            responseMessage(&response, 500, "Internal", "HTTP method not supported");
-            send(info->socket_desc, response, strlen(response), 0);
-            goto cleanup;
-        }
-
-        sprintf(response, "HTTP/1.1 200 OK\r\n\r\n");
-        strncat(response, response_data, file_size + 200 - strlen(response) - 1);
-        strncat(response, "\r\n\r\n", file_size + 200 - strlen(response) - 1);
-
-        send(info->socket_desc, response, strlen(response), 0);
-        goto cleanup;
+        serve_static_asset(asset, if_none_match, response);
+        return;
     }
 
     printf("Check the HTTP method\n");
     if (strcmp(method, "GET") == 0) {
-        handle_get(info, queryString, destination, &response);
+        handle_get(info, queryString, destination, response);
     } else if (strcmp(method, "POST") == 0) {
-        handle_post(info, request, destination, &response);
+        handle_post(info, body, body_length, destination, response);
     } else if (strcmp(method, "PUT") == 0) {
-        handle_put(info, request, destination, &response);
+        handle_put(info, body, body_length, destination, response);
     } else if (strcmp(method, "DELETE") == 0) {
-        handle_delete(info, destination, &response);
+        handle_delete(info, destination, response);
     } else {
-        responseMessage(&response, 405, "Method Not Allowed", "HTTP method not supported");
+        responseMessage(response, 405, "Method Not Allowed", "HTTP method not supported");
     }
+    release_thread_database();
+}
 
-	cleanup:
-    if (response == NULL) {
-        responseMessage(&response, 500, "Internal Server Error", "Something Went Wrong.");
-    }
-    send(info->socket_desc, response, strlen(response), 0);
+// The request was parsed in place, path and query are NUL terminated inside info->buffer
+void process_request(ConnectionInfo *info, HTTPRequest *request, HTTPResponse *response) {
+    dispatch_request(info,
+        http_slice(info->buffer, request->method),
+        http_slice(info->buffer, request->path),
+        http_slice(info->buffer, request->query),
+        http_slice(info->buffer, request->body),
+        request->body.length,
+        http_get_header(request, info->buffer, "If-None-Match"),
+        response);
+}
+
+// Runs as a worker pool task once the reactor sees the socket readable.
+// Every complete (possibly pipelined) request is answered in order, then the
+// connection goes back to the reactor unless it has to be closed.
+static void serve_connection(ConnectionInfo *info) {
+	// Drain the socket. The buffer doubles so large bodies are not copied over and over,
+	// but never past the largest request; what is left stays in the socket for later.
+	size_t max_size = MAX_REQUEST_SIZE > HTTP_MAX_HEAD_SIZE ? (size_t) MAX_REQUEST_SIZE : HTTP_MAX_HEAD_SIZE;
+	char peer_closed = FALSE;
+	while (TRUE) {
+		if (info->buffer_len == info->buffer_size) {
+			if (info->buffer_size >= max_size) {
+				break;
+			}
+			size_t new_size = info->buffer_size == 0 ? INITIAL_BUFFER_SIZE : info->buffer_size * 2;
+			if (new_size > max_size) {
+				new_size = max_size;
+			}
+			char *new_buffer = realloc(info->buffer, new_size);
+			if (new_buffer == NULL) {
+				perror("realloc");
+				close_connection(info);
+				return;
+			}
+			info->buffer = new_buffer;
+			info->buffer_size = new_size;
+		}
+
+		ssize_t valread = read(info->socket_desc, info->buffer + info->buffer_len, info->buffer_size - info->buffer_len);
+		if (valread > 0) {
+			info->buffer_len += valread;
+		} else if (valread == 0) {
+			peer_closed = TRUE;
+			break;
+		} else if (errno == EINTR) {
+			continue;
+		} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			break;
+		} else {
+			perror("read");
+			close_connection(info);
+			return;
+		}
+	}
+
+	// The parser keeps its progress in info->request, a partial request resumes on the next read
+	while (TRUE) {
+		HTTPRequest *request = &info->request;
+		int rs = http_parse_request(request, info->buffer, info->buffer_len, max_size);
+		if (rs == HTTP_PARSE_INCOMPLETE) {
+			// A full buffer that still does not hold the request would never get more room
+			if (info->buffer_len < max_size) {
+				break;
+			}
+			rs = HTTP_PARSE_TOO_LARGE;
+		}
+
+		// Everything the handlers allocate for this request comes from the arena,
+		// and the routes they look at stay valid until the request is over
+		arena_begin();
+		epoch_enter();
+		HTTPResponse response;
+		http_response_init(&response);
+		char keep_alive = request->keep_alive;
+		size_t length = request->length;
+		if (rs == HTTP_PARSE_ERROR) {
+			responseMessage(&response, 400, "Bad Request", "Malformed request");
+			keep_alive = FALSE;
+		} else if (rs == HTTP_PARSE_TOO_LARGE) {
+			// The rest of the body is never read, so the connection cannot be reused
+			responseMessage(&response, 413, "Payload Too Large", "Request is too large");
+			keep_alive = FALSE;
+		} else {
+			process_request(info, request, &response);
+		}
+
+		if (response.status_code == 0) {
+			responseMessage(&response, 500, "Internal Server Error", "Something Went Wrong.");
+		}
+		char sent = http_response_send(&response, info->socket_desc, keep_alive);
+		http_response_reset(&response);
+		epoch_exit();
+		arena_end();
+
+		if (sent == FALSE || keep_alive == FALSE) {
+			close_connection(info);
+			return;
+		}
+
+		memmove(info->buffer, info->buffer + length, info->buffer_len - length);
+		info->buffer_len -= length;
+		http_request_reset(request);
+		// The next request's timeouts start when its own bytes are seen
+		info->request_started = 0;
+		info->body_started = 0;
+	}
 
+	if (peer_closed) {
+		close_connection(info);
+		return;
+	}
 
-    close_socket_and_exit(info);
-    free(response);
-    return NULL;
+	reactor_rearm(info->reactor, info);
 }
 
+// Runs on a worker for each readable connection the reactor admitted
+void handle_connection(void *connectioninfo) {
+    ConnectionInfo* info = (ConnectionInfo*) connectioninfo;
+
+    admission_request_started();
+    serve_connection(info);
+    admission_request_end();
+}
 
-cJSON *get_json_from_request(const char *request) {
-    char *json_start = strstr(request, "{");
-    if (json_start == NULL) {
-        return NULL;
-    }
 
-    size_t json_length = strlen(json_start);
-    char *json_data = (char *)malloc(json_length + 1);
-    if (json_data == NULL) {
+cJSON *get_json_from_request(const char *body, size_t length) {
+    if (length == 0) {
         return NULL;
     }
-
-    strncpy(json_data, json_start, json_length);
-    json_data[json_length] = '\0';
-
-    cJSON *json_object = cJSON_Parse(json_data);
-    free(json_data);
-    return json_object;
+    return cJSON_ParseWithLength(body, length);
 }
 
 cJSON *get_first_child(cJSON *json_object) {
@@ -0,0 +1,219 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "Common.h"
+
+static RouteCache cache;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static Slab entry_slab = SLAB_INITIALIZER(sizeof(RouteCacheEntry));
+
+char init_route_cache(int capacity) {
+    cache.capacity = capacity > 0 ? (size_t) capacity : 0;
+    cache.num_buckets = 16;
+    while (cache.num_buckets < cache.capacity) {
+        cache.num_buckets *= 2;
+    }
+    cache.buckets = calloc(cache.num_buckets, sizeof(RouteCacheEntry *));
+    if (cache.buckets == NULL) {
+        fprintf(stderr, "Failed to allocate the route cache\n");
+        return FALSE;
+    }
+    cache.count = 0;
+    cache.head = cache.tail = NULL;
+    return TRUE;
+}
+
+void free_route_cache(void) {
+    RouteCacheEntry *entry = cache.head;
+    while (entry != NULL) {
+        RouteCacheEntry *next = entry->next;
+        free_route(entry->route);
+        entry = next;
+    }
+    free_slab(&entry_slab);
+    free(cache.buckets);
+    cache.buckets = NULL;
+    cache.head = cache.tail = NULL;
+    cache.count = 0;
+}
+
+static RouteCacheEntry **find_link(const char *key, unsigned long hash) {
+    RouteCacheEntry **link = &cache.buckets[hash & (cache.num_buckets - 1)];
+    while (*link != NULL && ((*link)->route->hash != hash || strcmp((*link)->route->key, key) != 0)) {
+        link = &(*link)->hash_next;
+    }
+    return link;
+}
+
+static void unlink_lru(RouteCacheEntry *entry) {
+    if (entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    } else {
+        cache.head = entry->next;
+    }
+    if (entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    } else {
+        cache.tail = entry->prev;
+    }
+}
+
+static void push_front(RouteCacheEntry *entry) {
+    entry->prev = NULL;
+    entry->next = cache.head;
+    if (cache.head != NULL) {
+        cache.head->prev = entry;
+    } else {
+        cache.tail = entry;
+    }
+    cache.head = entry;
+}
+
+// A request may still be using the route, it is freed once every reader has left
+static void drop_entry(RouteCacheEntry **link) {
+    RouteCacheEntry *entry = *link;
+    *link = entry->hash_next;
+    unlink_lru(entry);
+    cache.count--;
+    epoch_retire(entry->route, free_route);
+    slab_free(&entry_slab, entry);
+}
+
+// Takes ownership of route. With a cache of size 0 nothing is kept and the route
+// is only good for the current request.
+static struct Route *insert_route(struct Route *route) {
+    if (cache.capacity == 0) {
+        epoch_retire(route, free_route);
+        return route;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    RouteCacheEntry **link = find_link(route->key, route->hash);
+    if (*link != NULL) {
+        // Someone else loaded it first
+        struct Route *existing = (*link)->route;
+        pthread_mutex_unlock(&cache_lock);
+        free_route(route);
+        return existing;
+    }
+
+    RouteCacheEntry *entry = slab_alloc(&entry_slab);
+    if (entry == NULL) {
+        pthread_mutex_unlock(&cache_lock);
+        epoch_retire(route, free_route);
+        return route;
+    }
+    entry->route = route;
+    entry->hash_next = NULL;
+    *link = entry;
+    push_front(entry);
+    cache.count++;
+
+    while (cache.count > cache.capacity) {
+        RouteCacheEntry *oldest = cache.tail;
+        drop_entry(find_link(oldest->route->key, oldest->route->hash));
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return route;
+}
+
+struct Route *route_cache_add(const char *key, const char *ri, short ty, const char *rn) {
+    struct Route *route = initRoute((char *) key, (char *) ri, ty, (char *) rn);
+    if (route == NULL) {
+        return NULL;
+    }
+    route->hash = route_hash(route->key);
+    return insert_route(route);
+}
+
+// The instance has to belong to the container currently at that path, a row left
+// behind by a deleted container with the same name is not a match
+static struct Route *load_route(const char *key, const struct Route *container) {
+    sqlite3 *db = initDatabase("tiny-oneM2M.db");
+    if (db == NULL) {
+        return NULL;
+    }
+
+    sqlite3_stmt *stmt = prepare_statement(db, STMT_SELECT_ROUTE_CIN);
+    if (stmt == NULL) {
+        closeDatabase(db);
+        return NULL;
+    }
+    sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, container->ri, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 3, CIN);
+
+    struct Route *route = NULL;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        route = initRoute((char *) key, (char *) sqlite3_column_text(stmt, 0), CIN, (char *) sqlite3_column_text(stmt, 1));
+        if (route != NULL) {
+            route->hash = route_hash(route->key);
+        }
+    }
+    release_statement(stmt);
+    closeDatabase(db);
+    return route;
+}
+
+struct Route *route_cache_find(const char *key, const struct Route *container) {
+    unsigned long hash = route_hash(key);
+    if (cache.capacity > 0) {
+        pthread_mutex_lock(&cache_lock);
+        RouteCacheEntry *entry = *find_link(key, hash);
+        if (entry != NULL) {
+            unlink_lru(entry);
+            push_front(entry);
+            pthread_mutex_unlock(&cache_lock);
+            return entry->route;
+        }
+        pthread_mutex_unlock(&cache_lock);
+    }
+
+    struct Route *route = load_route(key, container);
+    if (route == NULL) {
+        return NULL;
+    }
+    return insert_route(route);
+}
+
+void route_cache_remove(const char *key) {
+    if (cache.capacity == 0) {
+        return;
+    }
+    pthread_mutex_lock(&cache_lock);
+    RouteCacheEntry **link = find_link(key, route_hash(key));
+    if (*link != NULL) {
+        drop_entry(link);
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+// Everything under key, for when a container goes away
+void route_cache_remove_below(const char *key) {
+    if (cache.capacity == 0) {
+        return;
+    }
+    size_t key_length = strlen(key);
+    pthread_mutex_lock(&cache_lock);
+    RouteCacheEntry *entry = cache.head;
+    while (entry != NULL) {
+        RouteCacheEntry *next = entry->next;
+        const char *route_key = entry->route->key;
+        if (strncmp(route_key, key, key_length) == 0 && route_key[key_length] == '/') {
+            drop_entry(find_link(route_key, entry->route->hash));
+        }
+        entry = next;
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
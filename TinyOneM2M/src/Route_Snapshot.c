@@ -0,0 +1,329 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Common.h"
+
+extern char DB_MEM[MAX_CONFIG_LINE_LENGTH];
+extern int ROUTE_SNAPSHOT_INTERVAL;
+
+static atomic_int snapshots_enabled = FALSE;
+static RouteTable *snapshot_table = NULL;
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static int64_t written_generation = -1;
+
+// The generation row gets a random id with the database, so a snapshot taken
+// against another (or a recreated) database never matches
+char init_route_snapshots(RouteTable *table) {
+    if (strcmp(DB_MEM, "true") == 0) {
+        return FALSE;
+    }
+    sqlite3 *db = initDatabase("tiny-oneM2M.db");
+    if (db == NULL) {
+        return FALSE;
+    }
+
+    char *sql = sqlite3_mprintf(
+        "CREATE TABLE IF NOT EXISTS route_generation (id INTEGER NOT NULL, value INTEGER NOT NULL);"
+        "INSERT INTO route_generation SELECT abs(random()), 0 WHERE NOT EXISTS (SELECT 1 FROM route_generation);"
+        "CREATE TRIGGER IF NOT EXISTS mtc_route_insert AFTER INSERT ON mtc_meta WHEN NEW.ty != %d "
+        "BEGIN UPDATE route_generation SET value = value + 1; END;"
+        "CREATE TRIGGER IF NOT EXISTS mtc_route_delete AFTER DELETE ON mtc_meta WHEN OLD.ty != %d "
+        "BEGIN UPDATE route_generation SET value = value + 1; END;",
+        CIN, CIN);
+    char *err_msg = NULL;
+    int rc = sqlite3_exec(db, sql, NULL, NULL, &err_msg);
+    sqlite3_free(sql);
+    closeDatabase(db);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to set up the route generation: %s\n", err_msg);
+        sqlite3_free(err_msg);
+        return FALSE;
+    }
+
+    snapshot_table = table;
+    snapshots_enabled = TRUE;
+    return TRUE;
+}
+
+static char read_generation(int64_t *database_id, int64_t *generation) {
+    sqlite3 *db = initDatabase("tiny-oneM2M.db");
+    if (db == NULL) {
+        return FALSE;
+    }
+    sqlite3_stmt *stmt;
+    char found = FALSE;
+    if (sqlite3_prepare_v2(db, "SELECT id, value FROM route_generation LIMIT 1;", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            *database_id = sqlite3_column_int64(stmt, 0);
+            *generation = sqlite3_column_int64(stmt, 1);
+            found = TRUE;
+        }
+        sqlite3_finalize(stmt);
+    } else {
+        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    }
+    closeDatabase(db);
+    return found;
+}
+
+// Everything is checked before the first route goes in, a bad file loads nothing
+static char validate_snapshot(const char *map, size_t size, int64_t database_id, int64_t generation) {
+    if (size < sizeof(RouteSnapshotHeader)) {
+        return FALSE;
+    }
+    const RouteSnapshotHeader *header = (const RouteSnapshotHeader *) map;
+    if (memcmp(header->magic, ROUTE_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->version != ROUTE_SNAPSHOT_VERSION) {
+        fprintf(stderr, "Route snapshot has an unknown format\n");
+        return FALSE;
+    }
+    if (header->database_id != database_id || header->generation != generation) {
+        printf("Route snapshot is from generation %lld, the database is at %lld\n", (long long) header->generation, (long long) generation);
+        return FALSE;
+    }
+
+    size_t entries_size = (size_t) header->count * sizeof(RouteSnapshotEntry);
+    if (header->strings_size == 0 || size - sizeof(RouteSnapshotHeader) < entries_size ||
+        size - sizeof(RouteSnapshotHeader) - entries_size != header->strings_size) {
+        fprintf(stderr, "Route snapshot is truncated\n");
+        return FALSE;
+    }
+    const RouteSnapshotEntry *entries = (const RouteSnapshotEntry *) (map + sizeof(RouteSnapshotHeader));
+    const char *strings = (const char *) (entries + header->count);
+    if (strings[header->strings_size - 1] != '\0') {
+        return FALSE;
+    }
+    for (uint32_t i = 0; i < header->count; i++) {
+        if (entries[i].key >= header->strings_size || entries[i].ri >= header->strings_size || entries[i].value >= header->strings_size) {
+            fprintf(stderr, "Route snapshot has an entry out of bounds\n");
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+char load_route_snapshot(RouteTable *table) {
+    if (snapshots_enabled == FALSE) {
+        return FALSE;
+    }
+    int64_t database_id, generation;
+    if (read_generation(&database_id, &generation) == FALSE) {
+        return FALSE;
+    }
+
+    int fd = open(ROUTE_SNAPSHOT_FILE, O_RDONLY);
+    if (fd < 0) {
+        printf("No route snapshot, scanning the database\n");
+        return FALSE;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return FALSE;
+    }
+    size_t size = (size_t) st.st_size;
+    char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return FALSE;
+    }
+
+    if (validate_snapshot(map, size, database_id, generation) == FALSE) {
+        munmap(map, size);
+        return FALSE;
+    }
+
+    const RouteSnapshotHeader *header = (const RouteSnapshotHeader *) map;
+    const RouteSnapshotEntry *entries = (const RouteSnapshotEntry *) (map + sizeof(RouteSnapshotHeader));
+    char *strings = (char *) (entries + header->count);
+    // Entries are in tree order, parents come before their children
+    for (uint32_t i = 0; i < header->count; i++) {
+        if (search(table, strings + entries[i].key) == NULL) {
+            addRoute(table, strings + entries[i].key, strings + entries[i].ri, entries[i].ty, strings + entries[i].value);
+        }
+    }
+    printf("Loaded %u routes from the snapshot (generation %lld)\n", header->count, (long long) generation);
+    written_generation = generation;
+    munmap(map, size);
+    return TRUE;
+}
+
+typedef struct {
+    RouteSnapshotEntry *entries;
+    uint32_t count, entries_capacity;
+    char *strings;
+    size_t strings_size, strings_capacity;
+} SnapshotBuffer;
+
+static uint32_t append_string(SnapshotBuffer *buffer, const char *s) {
+    size_t length = strlen(s) + 1;
+    if (buffer->strings_size + length > buffer->strings_capacity) {
+        size_t capacity = buffer->strings_capacity > 0 ? buffer->strings_capacity * 2 : 4096;
+        while (capacity < buffer->strings_size + length) {
+            capacity *= 2;
+        }
+        char *strings = realloc(buffer->strings, capacity);
+        if (strings == NULL) {
+            return UINT32_MAX;
+        }
+        buffer->strings = strings;
+        buffer->strings_capacity = capacity;
+    }
+    memcpy(buffer->strings + buffer->strings_size, s, length);
+    uint32_t offset = (uint32_t) buffer->strings_size;
+    buffer->strings_size += length;
+    return offset;
+}
+
+static char append_route(SnapshotBuffer *buffer, const struct Route *route) {
+    if (buffer->count == buffer->entries_capacity) {
+        uint32_t capacity = buffer->entries_capacity > 0 ? buffer->entries_capacity * 2 : 256;
+        RouteSnapshotEntry *entries = realloc(buffer->entries, capacity * sizeof(RouteSnapshotEntry));
+        if (entries == NULL) {
+            return FALSE;
+        }
+        buffer->entries = entries;
+        buffer->entries_capacity = capacity;
+    }
+    RouteSnapshotEntry *entry = &buffer->entries[buffer->count];
+    entry->key = append_string(buffer, route->key);
+    entry->ri = append_string(buffer, route->ri);
+    entry->value = append_string(buffer, route->value);
+    entry->ty = route->ty;
+    entry->reserved = 0;
+    if (entry->key == UINT32_MAX || entry->ri == UINT32_MAX || entry->value == UINT32_MAX || buffer->strings_size >= UINT32_MAX) {
+        return FALSE;
+    }
+    buffer->count++;
+    return TRUE;
+}
+
+// Written next to the old one and renamed over it, a crash never leaves half a file
+static char write_file(const SnapshotBuffer *buffer, int64_t database_id, int64_t generation) {
+    RouteSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ROUTE_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = ROUTE_SNAPSHOT_VERSION;
+    header.count = buffer->count;
+    header.database_id = database_id;
+    header.generation = generation;
+    header.strings_size = buffer->strings_size;
+
+    const char *tmp = ROUTE_SNAPSHOT_FILE ".tmp";
+    FILE *file = fopen(tmp, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s\n", tmp);
+        return FALSE;
+    }
+    char ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(buffer->entries, sizeof(RouteSnapshotEntry), buffer->count, file) == buffer->count &&
+              fwrite(buffer->strings, 1, buffer->strings_size, file) == buffer->strings_size &&
+              fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0 || !ok || rename(tmp, ROUTE_SNAPSHOT_FILE) != 0) {
+        fprintf(stderr, "Failed to write the route snapshot\n");
+        unlink(tmp);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static char snapshot_locked(RouteTable *table) {
+    int64_t database_id, generation;
+    unsigned long seq;
+    // A POST or DELETE between its commit and its route change would leave the
+    // table behind the generation read here, so only a quiet table is written
+    if (route_table_stable(table, &seq) == FALSE || read_generation(&database_id, &generation) == FALSE) {
+        return FALSE;
+    }
+    if (generation == written_generation) {
+        return TRUE;
+    }
+
+    SnapshotBuffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    char ok = TRUE;
+    epoch_enter();
+    for (struct Route *route = atomic_load(&table->first_root); route != NULL && ok; route = route_next(route, NULL)) {
+        if (route->ty != -1) {
+            ok = append_route(&buffer, route);
+        }
+    }
+    epoch_exit();
+
+    unsigned long seq_after;
+    if (ok && buffer.count > 0 && route_table_stable(table, &seq_after) && seq_after == seq) {
+        ok = write_file(&buffer, database_id, generation);
+        if (ok) {
+            written_generation = generation;
+        }
+    } else {
+        ok = FALSE;
+    }
+    free(buffer.entries);
+    free(buffer.strings);
+    return ok;
+}
+
+char write_route_snapshot(RouteTable *table) {
+    if (snapshots_enabled == FALSE || pthread_mutex_trylock(&snapshot_lock) != 0) {
+        return FALSE;
+    }
+    char rs = snapshot_locked(table);
+    pthread_mutex_unlock(&snapshot_lock);
+    return rs;
+}
+
+static void *snapshot_loop(void *arg) {
+    // Ctrl+C is handled on another thread, which may want the last snapshot
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    RouteTable *table = (RouteTable *) arg;
+    while (TRUE) {
+        sleep(ROUTE_SNAPSHOT_INTERVAL);
+        write_route_snapshot(table);
+    }
+    return NULL;
+}
+
+char start_route_snapshots(RouteTable *table) {
+    if (snapshots_enabled == FALSE || ROUTE_SNAPSHOT_INTERVAL <= 0) {
+        return FALSE;
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, snapshot_loop, table) != 0) {
+        fprintf(stderr, "Failed to start the route snapshot thread\n");
+        return FALSE;
+    }
+    pthread_detach(thread);
+    return TRUE;
+}
+
+// Last snapshot before the table goes away, later calls do nothing
+void stop_route_snapshots(void) {
+    if (snapshots_enabled == FALSE) {
+        return;
+    }
+    pthread_mutex_lock(&snapshot_lock);
+    snapshot_locked(snapshot_table);
+    snapshots_enabled = FALSE;
+    pthread_mutex_unlock(&snapshot_lock);
+}
@@ -9,29 +9,248 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
+#include <ctype.h>
 
 #include "Common.h"
 
+// Nodes come from a slab, so the table's routes sit next to each other in a few
+// big pages instead of being scattered over the heap
+static Slab route_slab = SLAB_INITIALIZER(sizeof(struct Route));
+
+// NULL when out of memory
 struct Route * initRoute(char* key, char* ri, short ty, char* value) {
-	struct Route * temp = (struct Route *) malloc(sizeof(struct Route));
+	struct Route * temp = (struct Route *) slab_alloc(&route_slab);
+	if (temp == NULL) {
+		fprintf(stderr, "Failed to allocate the route for %s\n", key);
+		return NULL;
+	}
+
+	// key, ri and value share one allocation, in that order
+	size_t key_length = strlen(key) + 1;
+	size_t ri_length = strlen(ri) + 1;
+	size_t value_length = strlen(value) + 1;
+	char *strings = (char*) malloc(key_length + ri_length + value_length);
+	if (strings == NULL) {
+		fprintf(stderr, "Failed to allocate the route for %s\n", key);
+		slab_free(&route_slab, temp);
+		return NULL;
+	}
 
-	temp->key = (char*) malloc(strlen(key) + 1);
-	strcpy(temp->key, key);
+	temp->key = strings;
+	memcpy(temp->key, key, key_length);
     to_lowercase(temp->key);
 
-	temp->ri = (char*) malloc(strlen(ri) + 1);
-	strcpy(temp->ri, ri);
+	temp->ri = strings + key_length;
+	memcpy(temp->ri, ri, ri_length);
 
 	temp->ty = ty;
 	
-	temp->value = (char*) malloc(strlen(value) + 1);
-	strcpy(temp->value, value);
-
-	temp->left = temp->right = NULL;
+	temp->value = strings + key_length + ri_length;
+	memcpy(temp->value, value, value_length);
+
+	temp->hash = 0;
+	temp->ri_hash = temp->rn_hash = 0;
+	temp->indexed = FALSE;
+	temp->parent = NULL;
+	temp->first_child = temp->last_child = NULL;
+	temp->prev_sibling = temp->next_sibling = NULL;
+	temp->num_children = 0;
 	return temp;
 }
 
+// Marks a slot whose route was removed, probing goes on past it
+static struct Route route_deleted;
+#define ROUTE_DELETED (&route_deleted)
+
+// FNV-1a
+unsigned long route_hash(const char *key) {
+	unsigned long hash = 14695981039346656037UL;
+	for (const unsigned char *c = (const unsigned char *) key; *c != '\0'; c++) {
+		hash ^= *c;
+		hash *= 1099511628211UL;
+	}
+	return hash;
+}
+
+// Resource IDs come lowercased in URLs, so the ri index folds case
+static unsigned long resource_id_hash(const char *ri) {
+	unsigned long hash = 14695981039346656037UL;
+	for (const unsigned char *c = (const unsigned char *) ri; *c != '\0'; c++) {
+		hash ^= tolower(*c);
+		hash *= 1099511628211UL;
+	}
+	return hash;
+}
+
+static unsigned long rn_ty_hash(const char *rn, short ty) {
+	unsigned long hash = route_hash(rn);
+	hash ^= (unsigned short) ty;
+	hash *= 1099511628211UL;
+	return hash;
+}
+
+static RouteSlots *new_route_slots(size_t capacity) {
+	RouteSlots *slots = (RouteSlots *) calloc(1, sizeof(RouteSlots));
+	if (slots == NULL) {
+		return NULL;
+	}
+	slots->capacity = capacity;
+	slots->by_key = (RouteSlot *) calloc(capacity, sizeof(RouteSlot));
+	slots->by_ri = (RouteSlot *) calloc(capacity, sizeof(RouteSlot));
+	slots->by_rn = (RouteSlot *) calloc(capacity, sizeof(RouteSlot));
+	if (slots->by_key == NULL || slots->by_ri == NULL || slots->by_rn == NULL) {
+		free(slots->by_key);
+		free(slots->by_ri);
+		free(slots->by_rn);
+		free(slots);
+		return NULL;
+	}
+	return slots;
+}
+
+static void free_route_slots(void *ptr) {
+	RouteSlots *slots = (RouteSlots *) ptr;
+	free(slots->by_key);
+	free(slots->by_ri);
+	free(slots->by_rn);
+	free(slots);
+}
+
+void free_route(void *ptr) {
+	struct Route *route = (struct Route *) ptr;
+	free(route->key); // and ri and value with it
+	slab_free(&route_slab, route);
+}
+
+char init_route_table(RouteTable *table) {
+	RouteSlots *slots = new_route_slots(ROUTE_TABLE_INITIAL_CAPACITY);
+	if (slots == NULL) {
+		fprintf(stderr, "Failed to allocate the route table\n");
+		return FALSE;
+	}
+	atomic_init(&table->slots, slots);
+	table->count = 0;
+	atomic_init(&table->first_root, NULL);
+	atomic_init(&table->last_root, NULL);
+	atomic_init(&table->change_seq, 0);
+	atomic_init(&table->changes_in_flight, 0);
+	pthread_mutex_init(&table->write_lock, NULL);
+	return TRUE;
+}
+
+// Only once the server has stopped, nothing may be reading the table anymore.
+// Routes still in the route cache go with the slab, free_route_cache comes first.
+void free_route_table(RouteTable *table) {
+	RouteSlots *slots = atomic_load(&table->slots);
+	for (size_t i = 0; i < slots->capacity; i++) {
+		struct Route *route = atomic_load(&slots->by_key[i]);
+		if (route != NULL && route != ROUTE_DELETED) {
+			free_route(route);
+		}
+	}
+	free_route_slots(slots);
+	free_slab(&route_slab);
+	atomic_store(&table->slots, NULL);
+	atomic_store(&table->first_root, NULL);
+	atomic_store(&table->last_root, NULL);
+	table->count = 0;
+	pthread_mutex_destroy(&table->write_lock);
+}
+
+// Slot holding key, or the slot where it would go (the first deleted one seen, if any)
+static size_t find_slot(const RouteSlots *slots, const char *key, unsigned long hash) {
+	size_t mask = slots->capacity - 1;
+	size_t i = hash & mask;
+	size_t reuse = slots->capacity;
+	struct Route *route;
+	while ((route = atomic_load_explicit(&slots->by_key[i], memory_order_acquire)) != NULL) {
+		if (route == ROUTE_DELETED) {
+			if (reuse == slots->capacity) {
+				reuse = i;
+			}
+		} else if (route->hash == hash && strcmp(route->key, key) == 0) {
+			return i;
+		}
+		i = (i + 1) & mask;
+	}
+	return reuse != slots->capacity ? reuse : i;
+}
+
+// The ri and (rn, ty) arrays only ever get a route in or out, never look one up to replace it
+static void slot_insert(RouteSlot *array, size_t capacity, size_t *used, unsigned long hash, struct Route *route) {
+	size_t i = hash & (capacity - 1);
+	struct Route *current;
+	while ((current = atomic_load_explicit(&array[i], memory_order_relaxed)) != NULL && current != ROUTE_DELETED) {
+		i = (i + 1) & (capacity - 1);
+	}
+	if (current == NULL) {
+		(*used)++;
+	}
+	atomic_store_explicit(&array[i], route, memory_order_release);
+}
+
+static void slot_remove(RouteSlot *array, size_t capacity, unsigned long hash, const struct Route *route) {
+	size_t i = hash & (capacity - 1);
+	struct Route *current;
+	while ((current = atomic_load_explicit(&array[i], memory_order_relaxed)) != NULL) {
+		if (current == route) {
+			atomic_store_explicit(&array[i], ROUTE_DELETED, memory_order_release);
+			return;
+		}
+		i = (i + 1) & (capacity - 1);
+	}
+}
+
+// Templates have no ri, la and ol reuse the ri of their container
+static char is_indexed(const struct Route *route) {
+	if (route->ri[0] == '\0') {
+		return FALSE;
+	}
+	struct Route *parent = atomic_load(&route->parent);
+	return parent == NULL || strcmp(parent->ri, route->ri) != 0;
+}
+
+static void index_route(RouteSlots *slots, struct Route *route) {
+	slot_insert(slots->by_ri, slots->capacity, &slots->ri_used, route->ri_hash, route);
+	slot_insert(slots->by_rn, slots->capacity, &slots->rn_used, route->rn_hash, route);
+}
+
+static void unindex_route(RouteSlots *slots, struct Route *route) {
+	slot_remove(slots->by_ri, slots->capacity, route->ri_hash, route);
+	slot_remove(slots->by_rn, slots->capacity, route->rn_hash, route);
+}
+
+// Builds arrays with room for twice the routes, without the deleted markers,
+// and swaps them in. Readers still probing the old ones keep them until they leave.
+static char grow_table(RouteTable *table) {
+	RouteSlots *old = atomic_load(&table->slots);
+	size_t capacity = old->capacity;
+	while ((table->count + 1) * 10 >= capacity * 5) {
+		capacity *= 2;
+	}
+
+	RouteSlots *slots = new_route_slots(capacity);
+	if (slots == NULL) {
+		fprintf(stderr, "Failed to grow the route table\n");
+		return FALSE;
+	}
+	for (size_t i = 0; i < old->capacity; i++) {
+		struct Route *route = atomic_load(&old->by_key[i]);
+		if (route == NULL || route == ROUTE_DELETED) {
+			continue;
+		}
+		slot_insert(slots->by_key, capacity, &slots->used, route->hash, route);
+		if (route->indexed) {
+			index_route(slots, route);
+		}
+	}
+	atomic_store(&table->slots, slots);
+	epoch_retire(old, free_route_slots);
+	return TRUE;
+}
+
 // function to recursively construct the string for a resource
 //__deprecated
 char * constructPath(char * result, char * resourceName, char * parentName, struct sqlite3 *db) {
@@ -52,14 +271,13 @@ char * constructPath(char * result, char * resourceName, char * parentName, stru
 	*/
 	if (strcmp("", parentName) != 0) {
 		// get the parent record
-		char *sql = sqlite3_mprintf("SELECT rn, pi FROM mtc WHERE ri='%s'", parentName);
 		sqlite3_stmt *stmt;
-		int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
-		sqlite3_free(sql);
+		int rc = sqlite3_prepare_v2(db, "SELECT rn, pi FROM mtc_meta WHERE ri = ?;", -1, &stmt, 0);
 		if(rc != SQLITE_OK) {
 			fprintf(stderr, "SQL error: %s\n", sqlite3_errmsg(db));
 			exit(0);
 		}
+		sqlite3_bind_text(stmt, 1, parentName, -1, SQLITE_STATIC);
 		
 		if(sqlite3_step(stmt) == SQLITE_ROW) {
 
@@ -68,6 +286,7 @@ char * constructPath(char * result, char * resourceName, char * parentName, stru
 			char * parentParentId = (char *) sqlite3_column_text(stmt, 1);
 			strcat(result, constructPath(result, parentResourceName,parentParentId,db));
 			// concatenate the resourceName with the string
+			sqlite3_finalize(stmt);
 		} else {
 			fprintf(stderr, "Resource not found: %s\n", parentName);
 			sqlite3_finalize(stmt);
@@ -82,7 +301,7 @@ char * constructPath(char * result, char * resourceName, char * parentName, stru
 	return result;
 }
 
-char init_routes(struct Route** head) {
+char init_routes(RouteTable *table) {
     printf("Initializing routes\n");
     // call the constructPath function for each resource in the database
 
@@ -94,7 +313,10 @@ char init_routes(struct Route** head) {
 	}
 
     sqlite3_stmt *stmt;
-    short rc = sqlite3_prepare_v2(db, "SELECT ri, pi, ty, rn, url FROM mtc;", -1, &stmt, 0);
+    // Only the structure is kept resident, CINs are looked up when they are requested
+    char *sql = sqlite3_mprintf("SELECT ri, pi, ty, rn, url FROM mtc_meta WHERE ty != %d;", CIN);
+    short rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    sqlite3_free(sql);
     if(rc != SQLITE_OK) {
         fprintf(stderr, "SQL error: %s\n", sqlite3_errmsg(db));
         return FALSE;
@@ -117,7 +339,7 @@ char init_routes(struct Route** head) {
 		
 		// Add New Routes
 		to_lowercase(uri);
-		addRoute(head, uri, resourceId, resourceType, resourceName);
+		addRoute(table, uri, resourceId, resourceType, resourceName);
 
 		// when we are creating CNT routes we need to make available the route 'la' and 'li' routes
 		if (resourceType == CNT) {
@@ -138,8 +360,8 @@ char init_routes(struct Route** head) {
 			sprintf(url_ol, "%s/ol", uri);
 			sprintf(url_la, "%s/la", uri);
 
-			addRoute(head, url_ol, resourceId, CIN, "ol");
-			addRoute(head, url_la, resourceId, CIN, "la");
+			addRoute(table, url_ol, resourceId, CIN, "ol");
+			addRoute(table, url_la, resourceId, CIN, "la");
 		}
 		
 
@@ -157,112 +379,311 @@ char init_routes(struct Route** head) {
 	return TRUE;
 }
 
-void inorder(struct Route* head)
-{
-    struct Route* current = head;
+// Next route after route in a depth first walk, parents before their children.
+// With subtree set the walk stays below it, with NULL it goes over the whole tree.
+struct Route *route_next(const struct Route *route, const struct Route *subtree) {
+	struct Route *next = atomic_load(&route->first_child);
+	if (next != NULL) {
+		return next;
+	}
+	while (route != NULL && route != subtree) {
+		next = atomic_load(&route->next_sibling);
+		if (next != NULL) {
+			return next;
+		}
+		route = atomic_load(&route->parent);
+	}
+	return NULL;
+}
+
+// A request that writes a resource to the database and then updates its routes
+// runs between these two, so readers of the whole table can tell when the table
+// may be behind the database
+void route_change_begin(RouteTable *table) {
+	atomic_fetch_add(&table->changes_in_flight, 1);
+	atomic_fetch_add(&table->change_seq, 1);
+}
+
+void route_change_end(RouteTable *table) {
+	atomic_fetch_add(&table->change_seq, 1);
+	atomic_fetch_sub(&table->changes_in_flight, 1);
+}
 
-    while (current != NULL) {
+// TRUE when no change is running; the table is unchanged for as long as seq stays the same
+char route_table_stable(RouteTable *table, unsigned long *seq) {
+	*seq = atomic_load(&table->change_seq);
+	return atomic_load(&table->changes_in_flight) == 0;
+}
+
+void inorder(RouteTable *table)
+{
+    for (struct Route *current = atomic_load(&table->first_root); current != NULL; current = route_next(current, NULL)) {
         printf("%s -> %s -> %d -> %s \n", current->key, current->ri, current->ty, current->value);
-        current = current->right;
     }
 }
 
-int count_same_types(struct Route* head, int type) {
+int count_same_types(RouteTable *table, int type) {
     int count = 0;
-    struct Route* current = head;
-    while (current != NULL) {
+    for (struct Route *current = atomic_load(&table->first_root); current != NULL; current = route_next(current, NULL)) {
         if (current->ty == type) {
             count++;
         }
-        current = current->right;
     }
     return count;
 }
 
-struct Route * addRoute(struct Route **head, char* key, char* ri, short ty, char* value) {
-	// create a new node with the given fields
+// The route is complete before the store that makes it reachable
+static void link_route(RouteTable *table, struct Route *parent, struct Route *route) {
+	RouteSlot *first = parent != NULL ? &parent->first_child : &table->first_root;
+	RouteSlot *last = parent != NULL ? &parent->last_child : &table->last_root;
+	struct Route *tail = atomic_load(last);
+
+	atomic_store(&route->parent, parent);
+	atomic_store(&route->prev_sibling, tail);
+	atomic_store(&route->next_sibling, NULL);
+	if (tail != NULL) {
+		atomic_store(&tail->next_sibling, route);
+	} else {
+		atomic_store(first, route);
+	}
+	atomic_store(last, route);
+	if (parent != NULL) {
+		parent->num_children++;
+	}
+}
+
+// The route keeps its own links, a reader standing on it still finds its way
+// back into the tree
+static void unlink_route(RouteTable *table, struct Route *route) {
+	struct Route *parent = atomic_load(&route->parent);
+	struct Route *prev = atomic_load(&route->prev_sibling);
+	struct Route *next = atomic_load(&route->next_sibling);
+	RouteSlot *first = parent != NULL ? &parent->first_child : &table->first_root;
+	RouteSlot *last = parent != NULL ? &parent->last_child : &table->last_root;
+
+	if (prev != NULL) {
+		atomic_store(&prev->next_sibling, next);
+	} else {
+		atomic_store(first, next);
+	}
+	if (next != NULL) {
+		atomic_store(&next->prev_sibling, prev);
+	} else {
+		atomic_store(last, prev);
+	}
+	if (parent != NULL) {
+		parent->num_children--;
+	}
+}
+
+struct Route * addRoute(RouteTable *table, char* key, char* ri, short ty, char* value) {
+	// create a new node with the given fields, the key is lowercased by initRoute
 	struct Route *newNode = initRoute(key, ri, ty, value);
+	if (newNode == NULL) {
+		return NULL;
+	}
+	newNode->hash = route_hash(newNode->key);
+
+	pthread_mutex_lock(&table->write_lock);
+	RouteSlots *slots = atomic_load(&table->slots);
+	size_t slot = find_slot(slots, newNode->key, newNode->hash);
+	struct Route *existing = atomic_load(&slots->by_key[slot]);
+	if (existing != NULL && existing != ROUTE_DELETED) {
+		pthread_mutex_unlock(&table->write_lock);
+		printf("A Route For \"%s\" Already Exists\n", key);
+		free_route(newNode);
+		return existing; // return the existing node with the same key
+	}
 
-	// check if the list is empty
-	if (*head == NULL) {
-		*head = newNode;
-		return newNode;
-	}
-
-	// traverse the list to find the correct position to insert the new node
-	struct Route *current = *head;
-	while (current != NULL) {
-		if (strcmp(key, current->key) == 0) {
-			printf("A Route For \"%s\" Already Exists\n", key);
-			return current; // return the existing node with the same key
-		} else if (strcmp(key, current->key) > 0) {
-			// move to the next node in the list
-			if (current->right == NULL) {
-				// insert the new node at the end of the list
-				current->right = newNode;
-				newNode->left = current;
-				return newNode;
-			}
-			current = current->right;
-		} else {
-			// insert the new node before the current node
-			if (current->left == NULL) {
-				// insert the new node at the beginning of the list
-				newNode->right = current;
-				current->left = newNode;
-				*head = newNode;
-				return newNode;
-			} else {
-				current->left->right = newNode;
-				newNode->left = current->left;
-				newNode->right = current;
-				current->left = newNode;
-				return newNode;
-			}
+	size_t limit = slots->capacity * 7;
+	if ((slots->used + 1) * 10 >= limit || (slots->ri_used + 1) * 10 >= limit || (slots->rn_used + 1) * 10 >= limit) {
+		if (grow_table(table) == FALSE) {
+			pthread_mutex_unlock(&table->write_lock);
+			free_route(newNode);
+			return NULL;
 		}
+		slots = atomic_load(&table->slots);
 	}
-	return NULL;
+
+	// The parent is the key up to its last segment, "/onem2m" hangs from "/"
+	struct Route *parent = NULL;
+	char *last_slash = strrchr(newNode->key, '/');
+	if (last_slash != NULL && last_slash[1] != '\0') {
+		char *cut = last_slash == newNode->key ? last_slash + 1 : last_slash;
+		char saved = *cut;
+		*cut = '\0';
+		parent = search(table, newNode->key);
+		*cut = saved;
+	}
+	link_route(table, parent, newNode);
+	if (is_indexed(newNode)) {
+		newNode->ri_hash = resource_id_hash(newNode->ri);
+		newNode->rn_hash = rn_ty_hash(newNode->value, newNode->ty);
+		newNode->indexed = TRUE;
+		index_route(slots, newNode);
+	}
+	slot_insert(slots->by_key, slots->capacity, &slots->used, newNode->hash, newNode);
+	table->count++;
+
+	// Routes loaded before their parent hang from the roots until it shows up
+	size_t key_len = strlen(newNode->key);
+	struct Route *orphan = atomic_load(&table->first_root);
+	while (orphan != NULL) {
+		struct Route *next = atomic_load(&orphan->next_sibling);
+		if (orphan != newNode && strncmp(orphan->key, newNode->key, key_len) == 0 &&
+			orphan->key[key_len] == '/' && strchr(orphan->key + key_len + 1, '/') == NULL) {
+			unlink_route(table, orphan);
+			link_route(table, newNode, orphan);
+		}
+		orphan = next;
+	}
+	pthread_mutex_unlock(&table->write_lock);
+	return newNode;
 }
 
-struct Route* search(struct Route *root, const char *key) {
-    struct Route *current = root;
-    while (current != NULL) {
-        if (strcmp(key, current->key) == 0) {
-            return current;
-        } else if (strcmp(key, current->key) > 0) {
-            current = current->right;
-        } else {
-            break;
-        }
-    }
-    return NULL;
+static void remove_route(RouteTable *table, struct Route *route) {
+	RouteSlots *slots = atomic_load(&table->slots);
+	size_t slot = find_slot(slots, route->key, route->hash);
+	if (atomic_load(&slots->by_key[slot]) == route) {
+		atomic_store(&slots->by_key[slot], ROUTE_DELETED);
+		table->count--;
+	}
+	if (route->indexed) {
+		unindex_route(slots, route);
+	}
+
+	struct Route *child;
+	while ((child = atomic_load(&route->first_child)) != NULL) {
+		unlink_route(table, child);
+		link_route(table, NULL, child);
+	}
+	unlink_route(table, route);
+	epoch_retire(route, free_route);
 }
 
-struct Route* search_byri(struct Route* head, const char* ri) {
-    struct Route* current = head;
+// Takes a route out of the table and the tree. Its children, if any, become
+// roots; remove_subtree is the way to delete a resource. The route itself is
+// freed once no reader can be holding it.
+void removeRoute(RouteTable *table, struct Route *route) {
+	pthread_mutex_lock(&table->write_lock);
+	remove_route(table, route);
+	pthread_mutex_unlock(&table->write_lock);
+}
 
-    while (current != NULL) {
-        if (strcmp(current->ri, ri) == 0) {
-            return current;
-        }
-        current = current->right;
-    }
+// Removes a route and everything below it, children before their parents, in a
+// single walk over the subtree. A route someone else removed first is left alone,
+// the caller's epoch keeps it readable until then.
+void remove_subtree(RouteTable *table, struct Route *route) {
+	pthread_mutex_lock(&table->write_lock);
+	if (search(table, route->key) != route) {
+		pthread_mutex_unlock(&table->write_lock);
+		return;
+	}
+	struct Route *current = route;
+	while (TRUE) {
+		struct Route *child;
+		while ((child = atomic_load(&current->first_child)) != NULL) {
+			current = child;
+		}
+		if (current == route) {
+			break;
+		}
+		struct Route *parent = atomic_load(&current->parent);
+		printf("Deleting currentNode->key = %s\n", current->key);
+		remove_route(table, current);
+		current = parent;
+	}
+	remove_route(table, route);
+	pthread_mutex_unlock(&table->write_lock);
+}
 
-    return NULL;
+struct Route* search(RouteTable *table, const char *key) {
+	RouteSlots *slots = atomic_load_explicit(&table->slots, memory_order_acquire);
+	unsigned long hash = route_hash(key);
+	size_t slot = find_slot(slots, key, hash);
+	struct Route *route = atomic_load_explicit(&slots->by_key[slot], memory_order_acquire);
+	if (route == NULL || route == ROUTE_DELETED || strcmp(route->key, key) != 0) {
+		return NULL;
+	}
+	return route;
 }
 
-struct Route * search_byrn_ty(struct Route * root, char* rn, short ty) {
-	if (root == NULL) {
+// CINs are not in the table, a miss right below a container goes to the route cache
+struct Route *resolve_route(RouteTable *table, char *key) {
+	struct Route *route = search(table, key);
+	if (route != NULL) {
+		return route;
+	}
+
+	char *last_slash = strrchr(key, '/');
+	if (last_slash == NULL || last_slash == key || last_slash[1] == '\0') {
 		return NULL;
 	}
-	
-	if (ty == root->ty && strcmp(rn, root->value) == 0){
-		return root;
-	} else {
-		// Temos de garantir que o root que chega aqui é o primeiro, se não isto não faz sentido e teria de ser garantido de outra maneira
-		return search_byrn_ty(root->right, rn, ty);
+	*last_slash = '\0';
+	struct Route *container = search(table, key);
+	*last_slash = '/';
+	if (container == NULL || container->ty != CNT) {
+		return NULL;
+	}
+	return route_cache_find(key, container);
+}
+
+// Unstructured addressing, /<ri>. CINs are not in the ri index, their path is
+// read from the database and resolved through the route cache.
+struct Route *resolve_ri(RouteTable *table, const char *ri) {
+	struct Route *route = search_byri(table, ri);
+	if (route != NULL) {
+		return route;
+	}
+
+	sqlite3 *db = initDatabase("tiny-oneM2M.db");
+	if (db == NULL) {
+		return NULL;
+	}
+	sqlite3_stmt *stmt = prepare_statement(db, STMT_SELECT_URL_KEY_BY_RI);
+	if (stmt == NULL) {
+		closeDatabase(db);
+		return NULL;
+	}
+	sqlite3_bind_text(stmt, 1, ri, -1, SQLITE_STATIC);
+	sqlite3_bind_int(stmt, 2, CIN);
+	char *key = NULL;
+	if (sqlite3_step(stmt) == SQLITE_ROW) {
+		key = strdup((const char *) sqlite3_column_text(stmt, 0));
+	}
+	release_statement(stmt);
+	closeDatabase(db);
+	if (key == NULL) {
+		return NULL;
 	}
 
-	return root;
+	route = resolve_route(table, key);
+	free(key);
+	return route;
 }
 
+struct Route* search_byri(RouteTable *table, const char* ri) {
+	RouteSlots *slots = atomic_load_explicit(&table->slots, memory_order_acquire);
+	unsigned long hash = resource_id_hash(ri);
+	size_t mask = slots->capacity - 1;
+	struct Route *current;
+	for (size_t i = hash & mask; (current = atomic_load_explicit(&slots->by_ri[i], memory_order_acquire)) != NULL; i = (i + 1) & mask) {
+		if (current != ROUTE_DELETED && current->ri_hash == hash && strcasecmp(current->ri, ri) == 0) {
+			return current;
+		}
+	}
+	return NULL;
+}
+
+struct Route * search_byrn_ty(RouteTable *table, char* rn, short ty) {
+	RouteSlots *slots = atomic_load_explicit(&table->slots, memory_order_acquire);
+	unsigned long hash = rn_ty_hash(rn, ty);
+	size_t mask = slots->capacity - 1;
+	struct Route *current;
+	for (size_t i = hash & mask; (current = atomic_load_explicit(&slots->by_rn[i], memory_order_acquire)) != NULL; i = (i + 1) & mask) {
+		if (current != ROUTE_DELETED && current->rn_hash == hash && current->ty == ty && strcmp(rn, current->value) == 0) {
+			return current;
+		}
+	}
+	return NULL;
+}
@@ -31,7 +31,7 @@ SUBStruct *init_sub() {
     return sub;
 }
 
-char create_sub(SUBStruct *sub, cJSON *content, char **response) {
+char create_sub(SUBStruct *sub, cJSON *content, HTTPResponse *response) {
     // Sqlite3 initialization opening/creating database
     struct sqlite3 *db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
@@ -39,35 +39,15 @@ char create_sub(SUBStruct *sub, cJSON *content, char **response) {
         return FALSE;
     }
 
-    sqlite3_stmt *stmt;
-    int result;
-    const char *query = "SELECT COALESCE(MAX(CAST(substr(ri, 5) AS INTEGER)), 0) + 1 as result FROM mtc WHERE ty = 23";
-    // Prepare the SQL statement
-    if (sqlite3_prepare_v2(db, query, -1, &stmt, 0) != SQLITE_OK) {
-        fprintf(stderr, "Cannot prepare statement: %s\n", sqlite3_errmsg(db));
-        closeDatabase(db);
-        return FALSE;
-    }
-
-    char *ri = NULL;
-    // Execute the query and fetch the result
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        result = sqlite3_column_int(stmt, 0);
-        size_t ri_size = snprintf(NULL, 0, "CSUB%d", result) + 1; // Get the required size for the ri string
-
-        ri = malloc(ri_size * sizeof(char)); // Allocate dynamic memory for the ri string
-        if (ri == NULL) {
-            fprintf(stderr, "Failed to allocate memory for ri\n");
-            closeDatabase(db);
-            return FALSE;
-        }
-        snprintf(ri, ri_size, "CSUB%d", result); // Write the formatted string to ri
-        cJSON_AddStringToObject(content, "ri", ri);
-    } else {
-        fprintf(stderr, "Failed to fetch the result\n");
+    sqlite3_stmt *stmt = NULL;
+    char *ri = malloc(sizeof(sub->ri));
+    if (ri == NULL || allocate_id(db, SUB, ri, sizeof(sub->ri)) == FALSE) {
+        fprintf(stderr, "Failed to allocate the resource id\n");
+        free(ri);
         closeDatabase(db);
         return FALSE;
     }
+    cJSON_AddStringToObject(content, "ri", ri);
     sub->ty = SUB;
     strcpy(sub->ri, cJSON_GetObjectItemCaseSensitive(content, "ri")->valuestring);
     strcpy(sub->rn, cJSON_GetObjectItemCaseSensitive(content, "rn")->valuestring);
@@ -76,7 +56,7 @@ char create_sub(SUBStruct *sub, cJSON *content, char **response) {
 
     cJSON *et = cJSON_GetObjectItemCaseSensitive(content, "et");
     if (et) {
-        struct tm et_tm;
+        struct tm et_tm = {0};
         char *parse_result = strptime(et->valuestring, "%Y%m%dT%H%M%S", &et_tm);
         if (parse_result == NULL) {
             responseMessage(response, 400, "Bad Request", "Invalid date format");
@@ -85,12 +65,14 @@ char create_sub(SUBStruct *sub, cJSON *content, char **response) {
 
         time_t datetime_timestamp, current_time;
 
+        et_tm.tm_isdst = -1; // mktime works out daylight saving time itself
+
         datetime_timestamp = mktime(&et_tm);
         current_time = time(NULL);
 
         if (difftime(datetime_timestamp, current_time) < 0) {
             responseMessage(response, 400, "Bad Request", "Expiration time is in the past");
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             free(sub);
             return FALSE;
@@ -123,7 +105,7 @@ char create_sub(SUBStruct *sub, cJSON *content, char **response) {
                     sub->json_nu = (char *)malloc(len);
                     strcpy(sub->json_nu, json_str);
                 }
-                free(json_str); // Free the temporary JSON string
+                cJSON_free(json_str); // Free the temporary JSON string
             }
         } else if (json_array == NULL) {
             cJSON *empty_array = cJSON_CreateArray();
@@ -143,7 +125,7 @@ char create_sub(SUBStruct *sub, cJSON *content, char **response) {
                     sub->json_nu = (char *)malloc(len);
                     strcpy(sub->json_nu, empty_str);
                 }
-                free(empty_str); // Free the temporary JSON string
+                cJSON_free(empty_str); // Free the temporary JSON string
             }
             cJSON_Delete(empty_array); // Free the empty array
         }
@@ -153,7 +135,7 @@ char create_sub(SUBStruct *sub, cJSON *content, char **response) {
     char *json_string = cJSON_Print(sub_to_json(sub));
     if (json_string == NULL) {
         fprintf(stderr, "Failed to generate JSON string\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         free(sub);
         return FALSE;
@@ -163,12 +145,12 @@ char create_sub(SUBStruct *sub, cJSON *content, char **response) {
     sub->blob = (char *)malloc(rnLengthBlob);
     if (sub->blob == NULL) {
         fprintf(stderr, "Memory allocation error\n");
-        free(json_string);
+        cJSON_free(json_string);
         free(sub);
         return FALSE;
     }
     strcpy(sub->blob, json_string);
-    free(json_string); // Free the temporary JSON string
+    cJSON_free(json_string); // Free the temporary JSON string
 
     short rc = begin_transaction(db);
     if (rc != SQLITE_OK) {
@@ -177,11 +159,8 @@ char create_sub(SUBStruct *sub, cJSON *content, char **response) {
         return FALSE;
     }
     // Prepare the insert statement
-    const char *insertSQL = "INSERT INTO mtc (ty, ri, rn, pi, et, ct, lt, url, blob, acpi, lbl, daci, nu, enc) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
-
-    rc = sqlite3_prepare_v2(db, insertSQL, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_INSERT_SUB);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Verify the request body");
         closeDatabase(db);
         return FALSE;
@@ -217,7 +196,7 @@ char create_sub(SUBStruct *sub, cJSON *content, char **response) {
         fprintf(stderr, "Failed to execute statement: %s\n", sqlite3_errmsg(db));
         responseMessage(response, 400, "Bad Request", "Verify the request body");
         rollback_transaction(db); // Rollback transaction
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
@@ -227,28 +206,21 @@ char create_sub(SUBStruct *sub, cJSON *content, char **response) {
     rc = commit_transaction(db);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Can't commit transaction\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
 
     // Finalize the statement and close the database
-    sqlite3_finalize(stmt);
+    release_statement(stmt);
 
-    char *sql_not = sqlite3_mprintf("SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');", sub->pi);
-    if (sql_not == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        return FALSE;
-    }
-    rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, sub->pi, -1, SQLITE_STATIC);
 
     // Populate the CNT
     pthread_t thread_id;
@@ -368,30 +340,24 @@ cJSON *sub_to_json(const SUBStruct *sub) {
     return root;
 }
 
-char update_sub(struct Route* destination, cJSON *content, char** response){
+char update_sub(struct Route* destination, cJSON *content, HTTPResponse *response){
     // retrieve the SUB from tge database
-    char *sql = sqlite3_mprintf("SELECT ty, ri, rn, pi, et, ct, lt, acpi, lbl, daci, nu, enc FROM mtc WHERE ri = '%s' AND ty = %d AND et > datetime('now');", destination->ri, SUB);
-    if (sql == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        return FALSE;
-    }
     sqlite3_stmt *stmt;
     struct sqlite3 * db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
         fprintf(stderr, "Failed to initialize the database.\n");
         responseMessage(response, 500, "Internal Server Error", "Failed to initialize the database.");
-        sqlite3_free(sql);
         return FALSE;
     }
-    short rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_SUB);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, destination->ri, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, SUB);
+    short rc;
 
     // Populate the SUB
     SUBStruct *sub = init_sub();
@@ -433,6 +399,7 @@ char update_sub(struct Route* destination, cJSON *content, char** response){
         strncpy(sub->enc, (char *)sqlite3_column_text(stmt, 11), 50);
         break;
     }
+    release_statement(stmt);
 
     // Update the MTC table
     char *updateQueryMTC = sqlite3_mprintf("UPDATE mtc SET "); //string to create query
@@ -470,7 +437,7 @@ char update_sub(struct Route* destination, cJSON *content, char** response){
             strcpy(sub->enc, item->valuestring);
         } else if (strcmp(key, "acpi") != 0 && strcmp(key, "lbl") != 0 && strcmp(key, "daci") != 0 && strcmp(key, "nu") != 0){
             responseMessage(response, 400, "Bad Request", "Invalid key");
-            sqlite3_finalize(stmt);
+            release_statement(stmt);
             closeDatabase(db);
             free(sub);
             return FALSE;
@@ -506,7 +473,7 @@ char update_sub(struct Route* destination, cJSON *content, char** response){
 
         // Add the expiration time into the update statement
         if(strcmp(key, "et") == 0) {
-            struct tm et_tm;
+            struct tm et_tm = {0};
             char *new_json_stringET = strdup(json_strITEM); // create a copy of json_strITEM
 
             // remove the last character from new_json_stringET
@@ -518,13 +485,14 @@ char update_sub(struct Route* destination, cJSON *content, char** response){
             if (parse_result == NULL) {
                 // The date string did not match the expected format
                 responseMessage(response, 400, "Bad Request", "Invalid date format");
-                sqlite3_finalize(stmt);
+                release_statement(stmt);
                 closeDatabase(db);
                 free(sub);
                 return FALSE;
             }
 
             // Convert the parsed time to a timestamp
+            et_tm.tm_isdst = -1; // mktime works out daylight saving time itself
             datetime_timestamp = mktime(&et_tm);
             // Get the current time
             current_time = time(NULL);
@@ -532,7 +500,7 @@ char update_sub(struct Route* destination, cJSON *content, char** response){
             // Compara o timestamp atual com o timestamp recebido, caso o timestamp está no passado dá excepção
             if (difftime(datetime_timestamp, current_time) < 0) {
                 responseMessage(response, 400, "Bad Request", "Expiration time is in the past");
-                sqlite3_finalize(stmt);
+                release_statement(stmt);
                 closeDatabase(db);
                 free(sub);
                 return FALSE;
@@ -549,19 +517,18 @@ char update_sub(struct Route* destination, cJSON *content, char** response){
     }
     strcpy(sub->lt,getCurrentTime());
     //blob
-    size_t rnLengthBlob = strlen(cJSON_Print(sub_to_json(sub)));
-    sub->blob = (char *)malloc(rnLengthBlob);
+    // Printed once, the update stores the same text
+    sub->blob = cJSON_Print(sub_to_json(sub));
     if (sub->blob == NULL) {
         // Handle memory allocation error
         fprintf(stderr, "Memory allocation error\n");
         free(sub);
         return FALSE;
     }
-    strcpy(sub->blob, cJSON_Print(sub_to_json(sub)));  
     // Se tiver o valor inical não é feito o update
     if(strcmp(updateQueryMTC, "UPDATE mtc SET ") != 0){
 
-        updateQueryMTC = sqlite3_mprintf("%slt = %Q, blob = \'%s\' WHERE ri = %Q AND ty = %d", updateQueryMTC, getCurrentTimeLong(), sub->blob,destination->ri, destination->ty);
+        updateQueryMTC = sqlite3_mprintf("%slt = %Q, blob = %Q WHERE ri = %Q AND ty = %d", updateQueryMTC, getCurrentTimeLong(), sub->blob,destination->ri, destination->ty);
 
         rc = sqlite3_exec(db, updateQueryMTC, NULL, NULL, &errMsg);
         if (rc != SQLITE_OK) {
@@ -584,19 +551,15 @@ char update_sub(struct Route* destination, cJSON *content, char** response){
         }
         
         // Retrieve the SUB with the updated expiration time
-        sql = sqlite3_mprintf("SELECT et, lt FROM mtc WHERE ri = '%s' AND ty = %d AND et > datetime('now');", destination->ri, destination->ty);
-
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            rollback_transaction(db);
-            printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        stmt = prepare_statement(db, STMT_SELECT_TIMES);
+        if (stmt == NULL) {
             responseMessage(response,400,"Bad Request","Error running select"); 
-            sqlite3_finalize(stmt);
-            sqlite3_free(errMsg);
             closeDatabase(db);
             free(sub);
             return FALSE;
         }
+        sqlite3_bind_text(stmt, 1, destination->ri, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, destination->ty);
 
         while (sqlite3_step(stmt) == SQLITE_ROW) {
             const char *et_iso = (const char *)sqlite3_column_text(stmt, 0);
@@ -616,50 +579,26 @@ char update_sub(struct Route* destination, cJSON *content, char** response){
     char *json_str = cJSON_Print(sub_to_json(sub));
     if (json_str == NULL) {
         fprintf(stderr, "Failed to print JSON as a string.\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         free(sub);
         return FALSE;
     }
     char * response_data = json_str;
     
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(response_data) + 1;
-    
-    // Allocate memory for the response buffer
-    *response = (char *)malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        sqlite3_finalize(stmt);
-        closeDatabase(db);
-        free(json_str);
-        free(sub);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", response_data);
+    // The printed JSON becomes the body, the response frees it once sent
+    http_response_json(response, 200, "OK", response_data, cJSON_free);
 
-    free(json_str);
-    sqlite3_finalize(stmt);
+    release_statement(stmt);
 
-    char *sql_not = sqlite3_mprintf("SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');", sub->pi);
-    if (sql_not == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-        free(sub);
-        return FALSE;
-    }
-    rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+    stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+    if (stmt == NULL) {
         responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-        sqlite3_finalize(stmt);
         closeDatabase(db);
         free(sub);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, sub->pi, -1, SQLITE_STATIC);
 
     // Populate the CNT
     pthread_t thread_id;
@@ -741,78 +680,50 @@ char update_sub(struct Route* destination, cJSON *content, char** response){
     return TRUE;
 }
 
-char get_sub(struct Route* destination, char** response){
-    char *sql = sqlite3_mprintf("SELECT blob, pi FROM mtc WHERE LOWER(url) = LOWER('%s') AND et > datetime('now');", destination->key);
-
-    if (sql == NULL) {
-        fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-        return FALSE;
-    }
+char get_sub(struct Route* destination, HTTPResponse *response){
     sqlite3_stmt *stmt;
-    struct sqlite3 * db = initDatabase("tiny-oneM2M.db");
+    struct sqlite3 *db = initDatabase("tiny-oneM2M.db");
     if (db == NULL) {
         fprintf(stderr, "Failed to initialize the database.\n");
-        sqlite3_free(sql);
         return FALSE;
     }
-    short rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
+    stmt = prepare_statement(db, STMT_SELECT_BLOB_BY_URL);
+    if (stmt == NULL) {
         closeDatabase(db);
         return FALSE;
     }
+    sqlite3_bind_text(stmt, 1, destination->key, -1, SQLITE_STATIC);
+    short rc;
     
     char *response_data = NULL;
     char *blob = NULL;
     char *pi = NULL;
     if ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
         response_data = (char *)sqlite3_column_text(stmt, 0); // note the change in index to 0
-        blob = malloc(strlen(response_data));
+        blob = malloc(strlen(response_data) + 1);
         strcpy(blob, response_data);
-        pi = malloc(strlen((char *)sqlite3_column_text(stmt, 1)));
+        pi = malloc(strlen((char *)sqlite3_column_text(stmt, 1)) + 1);
         strcpy(pi, (char *)sqlite3_column_text(stmt, 1));
     } else {
         fprintf(stderr, "Failed to print JSON as a string.\n");
         responseMessage(response, 400, "Bad Request", "Failed to print JSON as a string.\n");
-        sqlite3_finalize(stmt);
+        release_statement(stmt);
         closeDatabase(db);
         return FALSE;
     }
 
-    // Calculate the required buffer size
-    size_t response_size = strlen("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n") + strlen(response_data) + 1;
-    
-    // Allocate memory for the response buffer
-    *response = (char *)malloc(response_size * sizeof(char));
-
-    // Check if memory allocation was successful
-    if (*response == NULL) {
-        fprintf(stderr, "Failed to allocate memory for the response buffer\n");
-        // Cleanup
-        sqlite3_finalize(stmt);
-        closeDatabase(db);
-        free(response_data);
-        return FALSE;
-    }
-    sprintf(*response, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n%s", response_data);
-    sqlite3_finalize(stmt);
+    // The blob copy becomes the body, the response frees it once sent
+    http_response_json(response, 200, "OK", blob, free);
+    release_statement(stmt);
 
     if (blob != NULL) {
-        char *sql_not = sqlite3_mprintf("SELECT DISTINCT nu, url, enc FROM mtc WHERE LOWER(pi) = LOWER('%s') AND nu IS NOT NULL AND et > DATETIME('now');", pi);
-        if (sql_not == NULL) {
-            fprintf(stderr, "Failed to allocate memory for SQL query.\n");
-            responseMessage(response, 500, "Internal Server Error", "Failed to allocate memory for SQL query.");
-            return FALSE;
-        }
-        rc = sqlite3_prepare_v2(db, sql_not, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            printf("Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+        stmt = prepare_statement(db, STMT_SELECT_SUBSCRIBERS);
+        if (stmt == NULL) {
             responseMessage(response, 400, "Bad Request", "Failed to prepare statement.");
-            sqlite3_finalize(stmt);
             closeDatabase(db);
             return FALSE;
         }
+        sqlite3_bind_text(stmt, 1, pi, -1, SQLITE_STATIC);
         
         // Populate the CNT
         pthread_t thread_id;
@@ -11,16 +11,44 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
+#include <pthread.h>
 
 #include "Common.h"
 
-extern int client_socket; // declare the client_socket variable
+extern HTTP_Server http_server; // declare the http_server variable
+
+// Waits for Ctrl+C on its own thread, so the cleanup (the last route snapshot
+// takes locks, allocates and writes files) never runs inside a signal handler
+static void *sigint_loop(void *arg) {
+    sigset_t *set = (sigset_t *) arg;
+    int sig;
+    while (sigwait(set, &sig) != 0);
 
-void sigint_handler(int sig) {
-    // Code to execute when SIGINT is received
     printf("Ctrl+C pressed\n");
     // Do any necessary cleanup or other tasks here
-    close(client_socket);
+    close_server(&http_server);
+    stop_route_snapshots();
     // Exit the program
     exit(0);
+    return NULL;
+}
+
+// Call before any other thread starts, they all inherit SIGINT blocked
+char init_signals(void) {
+    static sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    if (pthread_sigmask(SIG_BLOCK, &set, NULL) != 0) {
+        fprintf(stderr, "Failed to block SIGINT\n");
+        return FALSE;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, sigint_loop, &set) != 0) {
+        fprintf(stderr, "Failed to start the signal thread\n");
+        pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+        return FALSE;
+    }
+    pthread_detach(thread);
+    return TRUE;
 }
\ No newline at end of file
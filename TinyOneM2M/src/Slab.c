@@ -0,0 +1,76 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Common.h"
+
+#define SLAB_ALIGNMENT 16
+#define SLAB_ALIGN(n) (((n) + SLAB_ALIGNMENT - 1) & ~((size_t) SLAB_ALIGNMENT - 1))
+#define SLAB_HEADER_SIZE SLAB_ALIGN(sizeof(SlabPage))
+
+static char new_page(Slab *slab) {
+    SlabPage *page = malloc(SLAB_PAGE_SIZE);
+    if (page == NULL) {
+        fprintf(stderr, "Failed to allocate a slab page\n");
+        return FALSE;
+    }
+    page->next = slab->pages;
+    slab->pages = page;
+    slab->next_object = (char *) page + SLAB_HEADER_SIZE;
+    slab->page_end = (char *) page + SLAB_PAGE_SIZE;
+    return TRUE;
+}
+
+void *slab_alloc(Slab *slab) {
+    size_t size = SLAB_ALIGN(slab->object_size);
+    void *object = NULL;
+
+    pthread_mutex_lock(&slab->lock);
+    if (slab->free_list != NULL) {
+        object = slab->free_list;
+        slab->free_list = *(void **) object;
+    } else if ((size_t) (slab->page_end - slab->next_object) >= size || new_page(slab) == TRUE) {
+        object = slab->next_object;
+        slab->next_object += size;
+    }
+    if (object != NULL) {
+        slab->in_use++;
+    }
+    pthread_mutex_unlock(&slab->lock);
+    return object;
+}
+
+void slab_free(Slab *slab, void *object) {
+    if (object == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&slab->lock);
+    *(void **) object = slab->free_list;
+    slab->free_list = object;
+    slab->in_use--;
+    pthread_mutex_unlock(&slab->lock);
+}
+
+// Every object goes with its page, nothing may point into the slab anymore
+void free_slab(Slab *slab) {
+    pthread_mutex_lock(&slab->lock);
+    SlabPage *page = slab->pages;
+    while (page != NULL) {
+        SlabPage *next = page->next;
+        free(page);
+        page = next;
+    }
+    slab->pages = NULL;
+    slab->free_list = NULL;
+    slab->next_object = slab->page_end = NULL;
+    slab->in_use = 0;
+    pthread_mutex_unlock(&slab->lock);
+}
@@ -8,9 +8,12 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "Utils.h"
 #include "sqlite3.h"
+#include "Sqlite.h"
 
 #define TRUE 1
 #define FALSE 0
@@ -26,10 +29,73 @@ int callback(void *NotUsed, int argc, char **argv, char **azColName) {
     return 0;
 }
 
-// Define an init function that returns an sqlite3 pointer
-sqlite3 *initDatabase(const char* databasename) {
+// Every thread keeps one connection open for as long as it lives. Opening the
+// file, reading the schema and warming the page cache happen once per thread,
+// not once per request.
+typedef struct {
+    sqlite3 *db;
+    sqlite3_stmt *statements[NUM_STATEMENTS]; // prepared on first use, kept until the thread exits
+    int depth; // initDatabase calls not closed yet, helpers open it inside their callers
+} ThreadDatabase;
+
+// The text of every statement the handlers keep prepared, indexed by StatementId
+static const char *statement_sql[NUM_STATEMENTS] = {
+    [STMT_INSERT_AE] = "INSERT INTO mtc (ty, ri, rn, pi, aei, api, rr, et, ct, lt, url, blob, acpi, lbl, daci, poa) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);",
+    [STMT_INSERT_CNT] = "INSERT INTO mtc (ty, ri, rn, pi, st, mni, mbs, cni, cbs, et, ct, lt, url, blob, acpi, lbl, daci) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);",
+    [STMT_INSERT_CIN] = "INSERT INTO mtc (ty, ri, rn, pi, st, cnf, cs, con, et, ct, lt, url, blob, lbl) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);",
+    [STMT_INSERT_SUB] = "INSERT INTO mtc (ty, ri, rn, pi, et, ct, lt, url, blob, acpi, lbl, daci, nu, enc) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);",
+    [STMT_SELECT_BLOB_BY_URL] = "SELECT blob, pi FROM mtc WHERE url_key = LOWER(?);",
+    [STMT_SELECT_BLOB_BY_RI] = "SELECT blob, pi, cni, cbs FROM mtc WHERE ri = ?;",
+    [STMT_SELECT_BLOB_BY_RI_TY] = "SELECT blob FROM mtc WHERE ri = ? AND ty = ?;",
+    [STMT_SELECT_LATEST_CIN] = "SELECT mtc_body.blob, mtc_meta.pi FROM mtc_meta JOIN mtc_body ON mtc_body.id = mtc_meta.id WHERE mtc_meta.pi = ? AND mtc_meta.ty = 4 ORDER BY mtc_meta.id DESC LIMIT 1;",
+    [STMT_SELECT_OLDEST_CIN] = "SELECT mtc_body.blob, mtc_meta.pi FROM mtc_meta JOIN mtc_body ON mtc_body.id = mtc_meta.id WHERE mtc_meta.pi = ? AND mtc_meta.ty = 4 ORDER BY mtc_meta.id ASC LIMIT 1;",
+    [STMT_SELECT_SUBSCRIBERS] = "SELECT DISTINCT nu, url, enc FROM mtc WHERE pi = ? AND nu IS NOT NULL;",
+    [STMT_SELECT_AE] = "SELECT ty, ri, rn, pi, aei, api, rr, et, ct, lt, acpi, lbl, daci, poa FROM mtc WHERE ri = ? AND ty = ?;",
+    [STMT_SELECT_CNT] = "SELECT ty, ri, rn, pi, st, mni, mbs, cni, cbs, et, ct, lt, acpi, lbl, daci FROM mtc WHERE url_key = LOWER(?);",
+    [STMT_SELECT_SUB] = "SELECT ty, ri, rn, pi, et, ct, lt, acpi, lbl, daci, nu, enc FROM mtc WHERE ri = ? AND ty = ?;",
+    [STMT_SELECT_AE_TIMES] = "SELECT rr, et, lt FROM mtc WHERE ri = ? AND ty = ?;",
+    [STMT_SELECT_TIMES] = "SELECT et, lt FROM mtc_meta WHERE ri = ? AND ty = ?;",
+    [STMT_SELECT_CNT_ST] = "SELECT st FROM mtc_meta WHERE url_key = LOWER(?);",
+    // cni and cbs live in their columns only, the CNT blob is not rewritten for them
+    [STMT_SELECT_CNT_BLOB] = "SELECT blob, pi, cni, cbs FROM mtc WHERE url_key = LOWER(?);",
+    [STMT_ADD_CNT_INSTANCE] = "UPDATE mtc_meta SET cni = cni + 1, cbs = cbs + ? WHERE ri = ? RETURNING cni, mni, cbs, mbs;",
+    [STMT_REMOVE_CNT_INSTANCES] = "UPDATE mtc_meta SET cni = cni - ?, cbs = cbs - ? WHERE ri = ?;",
+    [STMT_REMOVE_CNT_INSTANCE_BY_URL] = "UPDATE mtc_meta SET cni = cni - 1, cbs = cbs - (SELECT cs FROM mtc_meta WHERE ri = ?) WHERE url_key = LOWER(?);",
+    // Instance ids only grow, so a container's oldest instances are the ones up to a cutoff id
+    [STMT_SELECT_EVICTION_CUTOFF] = "SELECT id FROM mtc_meta WHERE pi = ?1 AND ty = 4 ORDER BY id LIMIT 1 OFFSET ?2 - 1;",
+    [STMT_SELECT_EVICTION_CUTOFF_BYTES] = "SELECT id FROM (SELECT id, ROW_NUMBER() OVER oldest_first AS n, SUM(cs) OVER oldest_first AS bytes FROM mtc_meta WHERE pi = ?1 AND ty = 4 WINDOW oldest_first AS (ORDER BY id ROWS UNBOUNDED PRECEDING)) WHERE n >= ?2 AND bytes >= ?3 LIMIT 1;",
+    [STMT_DELETE_EVICTED_BODIES] = "DELETE FROM mtc_body WHERE id IN (SELECT id FROM mtc_meta WHERE pi = ?1 AND ty = 4 AND id <= ?2);",
+    [STMT_DELETE_EVICTED] = "DELETE FROM mtc_meta WHERE pi = ?1 AND ty = 4 AND id <= ?2 RETURNING url, cs;",
+    [STMT_DELETE_BY_RI] = "DELETE FROM mtc WHERE ri = ?;",
+    [STMT_SELECT_ROUTE_CIN] = "SELECT ri, rn FROM mtc_meta WHERE url_key = ? AND pi = ? AND ty = ?;",
+    // Request paths arrive lowercased, the ids Id_Allocator hands out are uppercase
+    [STMT_SELECT_URL_KEY_BY_RI] = "SELECT url_key FROM mtc_meta WHERE ri = UPPER(?) AND ty = ?;",
+    // Soonest expiry first along idx_mtc_et, the CSE base has no et and is never picked.
+    // et is stored in local time, as the handlers write it.
+    [STMT_SELECT_EXPIRED] = "SELECT mtc_meta.ri, mtc_meta.ty, mtc_meta.pi, mtc_meta.url_key, mtc_meta.cs, mtc_meta.cni, mtc_meta.cbs, mtc_body.blob FROM mtc_meta JOIN mtc_body ON mtc_body.id = mtc_meta.id WHERE mtc_meta.et <= datetime('now', 'localtime') ORDER BY mtc_meta.et LIMIT ?;",
+};
+
+static pthread_key_t thread_database_key;
+static pthread_once_t thread_database_once = PTHREAD_ONCE_INIT;
+
+static void close_thread_database(void *ptr) {
+    ThreadDatabase *thread_db = (ThreadDatabase *) ptr;
+    sqlite3_stmt *stmt;
+    while ((stmt = sqlite3_next_stmt(thread_db->db, NULL)) != NULL) {
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(thread_db->db);
+    free(thread_db);
+}
+
+static void create_thread_database_key(void) {
+    pthread_key_create(&thread_database_key, close_thread_database);
+}
+
+static sqlite3 *open_database(const char* databasename) {
     sqlite3 *db;
-    int rc = sqlite3_open_v2((strcmp(DB_MEM, "true") == 0 ? ":memory:" : databasename), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, NULL);
+    char in_memory = strcmp(DB_MEM, "true") == 0;
+    int rc = sqlite3_open_v2((in_memory ? ":memory:" : databasename), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, NULL);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "Cannot open database: %s\n", sqlite3_errmsg(db));
         sqlite3_close(db);
@@ -38,9 +104,265 @@ sqlite3 *initDatabase(const char* databasename) {
 
     sqlite3_busy_timeout(db, 600);
 
+    // WAL lets the workers read while one of them writes, and with it a commit
+    // only has to reach the log, not the database file
+    if (!in_memory) {
+        sqlite3_exec(db, "PRAGMA journal_mode = WAL;", NULL, NULL, NULL);
+        sqlite3_exec(db, "PRAGMA synchronous = NORMAL;", NULL, NULL, NULL);
+    }
+    char pragmas[100];
+    snprintf(pragmas, sizeof(pragmas), "PRAGMA cache_size = -%d; PRAGMA temp_store = MEMORY;", DB_CACHE_SIZE_KB);
+    sqlite3_exec(db, pragmas, NULL, NULL, NULL);
+
     return db;
 }
 
+// Hands out the connection of the calling thread, opening it the first time
+sqlite3 *initDatabase(const char* databasename) {
+    pthread_once(&thread_database_once, create_thread_database_key);
+    ThreadDatabase *thread_db = pthread_getspecific(thread_database_key);
+    if (thread_db == NULL) {
+        thread_db = malloc(sizeof(ThreadDatabase));
+        if (thread_db == NULL) {
+            fprintf(stderr, "Cannot open database: out of memory\n");
+            return NULL;
+        }
+        thread_db->db = open_database(databasename);
+        memset(thread_db->statements, 0, sizeof(thread_db->statements));
+        thread_db->depth = 0;
+        if (thread_db->db == NULL) {
+            free(thread_db);
+            return NULL;
+        }
+        pthread_setspecific(thread_database_key, thread_db);
+    }
+    // Nobody holds the connection, so an open transaction was left by someone
+    // who never closed it. It is not ours to end, release_thread_database does.
+    if (thread_db->depth == 0 && sqlite3_get_autocommit(thread_db->db) == 0) {
+        fprintf(stderr, "WARNING: the database was opened with a transaction left open on this thread\n");
+    }
+    thread_db->depth++;
+    return thread_db->db;
+}
+
+static char is_cached_statement(ThreadDatabase *thread_db, sqlite3_stmt *stmt) {
+    for (int i = 0; i < NUM_STATEMENTS; i++) {
+        if (thread_db->statements[i] == stmt) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// Finalizes what was left on the connection and ends an open transaction
+static void reset_thread_database(ThreadDatabase *thread_db, char commit) {
+    sqlite3_stmt *stmt = sqlite3_next_stmt(thread_db->db, NULL);
+    while (stmt != NULL) {
+        sqlite3_stmt *next = sqlite3_next_stmt(thread_db->db, stmt);
+        if (is_cached_statement(thread_db, stmt)) {
+            sqlite3_reset(stmt);
+        } else {
+            sqlite3_finalize(stmt);
+        }
+        stmt = next;
+    }
+
+    if (sqlite3_get_autocommit(thread_db->db) == 0) {
+        if (commit == FALSE || sqlite3_exec(thread_db->db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+            sqlite3_exec(thread_db->db, "ROLLBACK", NULL, NULL, NULL);
+        }
+    }
+    thread_db->depth = 0;
+}
+
+// Called once a request is answered. A handler that returned without
+// closeDatabase must not leave its transaction or depth to the next request.
+void release_thread_database(void) {
+    pthread_once(&thread_database_once, create_thread_database_key);
+    ThreadDatabase *thread_db = pthread_getspecific(thread_database_key);
+    if (thread_db == NULL || thread_db->depth == 0) {
+        return;
+    }
+    fprintf(stderr, "WARNING: the request returned with the database still open (depth %d), rolling back\n", thread_db->depth);
+    reset_thread_database(thread_db, FALSE);
+}
+
+// Returns the statement ready to bind, preparing it only the first time the
+// thread asks for it. Give it back with release_statement, never finalize it.
+sqlite3_stmt *prepare_statement(sqlite3 *db, StatementId id) {
+    sqlite3_stmt *stmt = NULL;
+    ThreadDatabase *thread_db = pthread_getspecific(thread_database_key);
+    if (thread_db == NULL || thread_db->db != db) {
+        // Not the pooled connection, fall back to a one-off statement
+        if (sqlite3_prepare_v2(db, statement_sql[id], -1, &stmt, NULL) != SQLITE_OK) {
+            fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+            return NULL;
+        }
+        return stmt;
+    }
+
+    stmt = thread_db->statements[id];
+    if (stmt != NULL && sqlite3_stmt_busy(stmt)) {
+        // Still stepping in an enclosing call, this use gets its own copy
+        if (sqlite3_prepare_v2(db, statement_sql[id], -1, &stmt, NULL) != SQLITE_OK) {
+            fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+            return NULL;
+        }
+        return stmt;
+    }
+    if (stmt == NULL) {
+        if (sqlite3_prepare_v3(db, statement_sql[id], -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL) != SQLITE_OK) {
+            fprintf(stderr, "Failed to prepare statement: %s\n", sqlite3_errmsg(db));
+            return NULL;
+        }
+        thread_db->statements[id] = stmt;
+    }
+    sqlite3_clear_bindings(stmt);
+    return stmt;
+}
+
+// Resets a cached statement for its next use, finalizes any other one
+void release_statement(sqlite3_stmt *stmt) {
+    if (stmt == NULL) {
+        return;
+    }
+    ThreadDatabase *thread_db = pthread_getspecific(thread_database_key);
+    if (thread_db != NULL && is_cached_statement(thread_db, stmt)) {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    } else {
+        sqlite3_finalize(stmt);
+    }
+}
+
+// Resources are split in two tables sharing the same id. mtc_meta keeps the
+// short columns the lookups, counters and scans read, mtc_body the JSON text
+// that is only read when a representation is returned. The mtc view joins
+// them back, so the handlers keep reading and writing mtc as one table.
+static const char *schema_sql[] = {
+    "CREATE TABLE IF NOT EXISTS mtc_meta (id INTEGER PRIMARY KEY, ty INTEGER, ri TEXT UNIQUE, rn TEXT, pi TEXT, et DATETIME, ct DATETIME, lt DATETIME, url TEXT, cbs INTEGER, cni INTEGER, mbs INTEGER, mni INTEGER, st INTEGER, cs INTEGER, url_key TEXT GENERATED ALWAYS AS (LOWER(url)) VIRTUAL, FOREIGN KEY(pi) REFERENCES mtc_meta(ri) ON DELETE CASCADE);",
+    "CREATE TABLE IF NOT EXISTS mtc_body (id INTEGER PRIMARY KEY, aei TEXT, csi TEXT, cst INTEGER, api TEXT, rr TEXT, lbl TEXT, acpi TEXT, daci TEXT, poa TEXT, srt TEXT, blob TEXT, cnf TEXT, con TEXT, nu TEXT, enc TEXT, FOREIGN KEY(id) REFERENCES mtc_meta(id) ON DELETE CASCADE);",
+    "CREATE INDEX IF NOT EXISTS idx_mtc_et ON mtc_meta(et);",
+    "CREATE UNIQUE INDEX IF NOT EXISTS idx_mtc_url ON mtc_meta(url);",
+    "CREATE INDEX IF NOT EXISTS idx_mtc_url_key ON mtc_meta(url_key);",
+    "CREATE INDEX IF NOT EXISTS idx_mtc_pi_ty ON mtc_meta(pi, ty);",
+    "CREATE VIEW IF NOT EXISTS mtc AS SELECT mtc_meta.ty, mtc_meta.ri, mtc_meta.rn, mtc_meta.pi, mtc_body.aei, mtc_body.csi, mtc_body.cst, mtc_body.api, mtc_body.rr, mtc_meta.et, mtc_meta.ct, mtc_meta.lt, mtc_meta.url, mtc_body.lbl, mtc_body.acpi, mtc_body.daci, mtc_body.poa, mtc_body.srt, mtc_body.blob, mtc_meta.cbs, mtc_meta.cni, mtc_meta.mbs, mtc_meta.mni, mtc_meta.st, mtc_body.cnf, mtc_meta.cs, mtc_body.con, mtc_body.nu, mtc_body.enc, mtc_meta.url_key, mtc_meta.id FROM mtc_meta JOIN mtc_body ON mtc_body.id = mtc_meta.id;",
+    "CREATE TRIGGER IF NOT EXISTS mtc_insert INSTEAD OF INSERT ON mtc BEGIN "
+        "INSERT INTO mtc_meta (ty, ri, rn, pi, et, ct, lt, url, cbs, cni, mbs, mni, st, cs) VALUES (NEW.ty, NEW.ri, NEW.rn, NEW.pi, NEW.et, NEW.ct, NEW.lt, NEW.url, NEW.cbs, NEW.cni, NEW.mbs, NEW.mni, NEW.st, NEW.cs); "
+        "INSERT INTO mtc_body (id, aei, csi, cst, api, rr, lbl, acpi, daci, poa, srt, blob, cnf, con, nu, enc) VALUES (last_insert_rowid(), NEW.aei, NEW.csi, NEW.cst, NEW.api, NEW.rr, NEW.lbl, NEW.acpi, NEW.daci, NEW.poa, NEW.srt, NEW.blob, NEW.cnf, NEW.con, NEW.nu, NEW.enc); "
+        "END;",
+    // An UPDATE only rewrites the table holding the columns it sets
+    "CREATE TRIGGER IF NOT EXISTS mtc_update_meta INSTEAD OF UPDATE OF ty, ri, rn, pi, et, ct, lt, url, cbs, cni, mbs, mni, st, cs ON mtc BEGIN "
+        "UPDATE mtc_meta SET ty = NEW.ty, ri = NEW.ri, rn = NEW.rn, pi = NEW.pi, et = NEW.et, ct = NEW.ct, lt = NEW.lt, url = NEW.url, cbs = NEW.cbs, cni = NEW.cni, mbs = NEW.mbs, mni = NEW.mni, st = NEW.st, cs = NEW.cs WHERE id = OLD.id; "
+        "END;",
+    "CREATE TRIGGER IF NOT EXISTS mtc_update_body INSTEAD OF UPDATE OF aei, csi, cst, api, rr, lbl, acpi, daci, poa, srt, blob, cnf, con, nu, enc ON mtc BEGIN "
+        "UPDATE mtc_body SET aei = NEW.aei, csi = NEW.csi, cst = NEW.cst, api = NEW.api, rr = NEW.rr, lbl = NEW.lbl, acpi = NEW.acpi, daci = NEW.daci, poa = NEW.poa, srt = NEW.srt, blob = NEW.blob, cnf = NEW.cnf, con = NEW.con, nu = NEW.nu, enc = NEW.enc WHERE id = OLD.id; "
+        "END;",
+    // Children go with the foreign keys when they are on, like they did with the single table
+    "CREATE TRIGGER IF NOT EXISTS mtc_delete INSTEAD OF DELETE ON mtc BEGIN "
+        "DELETE FROM mtc_body WHERE id = OLD.id; "
+        "DELETE FROM mtc_meta WHERE id = OLD.id; "
+        "END;",
+};
+
+// The single mtc table older builds wrote is renamed out of the way, its rows
+// copied into mtc_meta and mtc_body keeping their ROWID as id (la/ol still see
+// them in order) and then dropped
+static const char *rename_single_sql[] = {
+    "DROP INDEX IF EXISTS idx_mtc_pi;",
+    "DROP INDEX IF EXISTS idx_mtc_ri;",
+    "DROP INDEX IF EXISTS idx_mtc_et;",
+    "DROP INDEX IF EXISTS idx_mtc_url;",
+    "DROP INDEX IF EXISTS idx_mtc_url_key;",
+    "DROP INDEX IF EXISTS idx_mtc_pi_ty;",
+    "ALTER TABLE mtc RENAME TO mtc_single;",
+};
+
+static const char *copy_single_sql[] = {
+    "INSERT INTO mtc_meta (id, ty, ri, rn, pi, et, ct, lt, url, cbs, cni, mbs, mni, st, cs) SELECT ROWID, ty, ri, rn, pi, et, ct, lt, url, cbs, cni, mbs, mni, st, cs FROM mtc_single;",
+    "INSERT INTO mtc_body (id, aei, csi, cst, api, rr, lbl, acpi, daci, poa, srt, blob, cnf, con, nu, enc) SELECT ROWID, aei, csi, cst, api, rr, lbl, acpi, daci, poa, srt, blob, cnf, con, nu, enc FROM mtc_single;",
+    "DROP TABLE mtc_single;",
+};
+
+static char exec_all(sqlite3 *db, const char **sql, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        char *err_msg = NULL;
+        if (sqlite3_exec(db, sql[i], NULL, NULL, &err_msg) != SQLITE_OK) {
+            fprintf(stderr, "Failed to set up the database (%s): %s\n", sql[i], err_msg);
+            sqlite3_free(err_msg);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// Creates whatever part of the schema is missing
+char create_schema(sqlite3 *db) {
+    return exec_all(db, schema_sql, sizeof(schema_sql) / sizeof(schema_sql[0]));
+}
+
+// Brings a database written by an older build up to the current schema. The
+// lookups by URL go through url_key, a lowercase copy of url kept in its index,
+// and the children of a resource are found by (pi, ty) in id order.
+char upgrade_database(sqlite3 *db) {
+    sqlite3_stmt *stmt;
+    char single_table = FALSE;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'mtc';", -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Failed to read the schema: %s\n", sqlite3_errmsg(db));
+        return FALSE;
+    }
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        single_table = sqlite3_column_int(stmt, 0) > 0;
+    }
+    sqlite3_finalize(stmt);
+
+    if (single_table == FALSE) {
+        return create_schema(db);
+    }
+
+    printf("Splitting the mtc table into mtc_meta and mtc_body.\n");
+    if (begin_transaction(db) != SQLITE_OK) {
+        return FALSE;
+    }
+    if (exec_all(db, rename_single_sql, sizeof(rename_single_sql) / sizeof(rename_single_sql[0])) == FALSE
+        || create_schema(db) == FALSE
+        || exec_all(db, copy_single_sql, sizeof(copy_single_sql) / sizeof(copy_single_sql[0])) == FALSE) {
+        rollback_transaction(db);
+        return FALSE;
+    }
+    return commit_transaction(db) == SQLITE_OK;
+}
+
+// Asks SQLite how it would run each cached statement and reports the ones that
+// read a whole table instead of searching an index
+char check_query_plans(sqlite3 *db) {
+    char all_indexed = TRUE;
+    for (int id = 0; id < NUM_STATEMENTS; id++) {
+        sqlite3_stmt *stmt;
+        char *sql = sqlite3_mprintf("EXPLAIN QUERY PLAN %s", statement_sql[id]);
+        int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        sqlite3_free(sql);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr, "Failed to explain statement %d: %s\n", id, sqlite3_errmsg(db));
+            all_indexed = FALSE;
+            continue;
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *detail = (const char *) sqlite3_column_text(stmt, 3);
+            // older releases than 3.36 word it "SCAN TABLE x". A bare "SCAN mtc"
+            // is an UPDATE or DELETE going over the view rows it already found,
+            // "SCAN (subquery-n)" the rows a subquery produced.
+            if (detail != NULL && strncmp(detail, "SCAN ", 5) == 0 && strncmp(detail, "SCAN (", 6) != 0
+                && strcmp(detail, "SCAN mtc") != 0 && strcmp(detail, "SCAN TABLE mtc") != 0) {
+                fprintf(stderr, "Statement %d scans the table (%s): %s\n", id, detail, statement_sql[id]);
+                all_indexed = FALSE;
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+    return all_indexed;
+}
+
 short execDatabaseScript(char* query, struct sqlite3 *db, short isCallback) {
     char *err_msg = 0;
     short rc = -1;
@@ -52,34 +374,30 @@ short execDatabaseScript(char* query, struct sqlite3 *db, short isCallback) {
     if (rc != SQLITE_OK) {
         fprintf(stderr, "SQL error: %s\n", err_msg);
         sqlite3_free(err_msg);
-        sqlite3_close(db);
+        closeDatabase(db);
         return FALSE;
     }
     return TRUE;
 }
 
+// Gives the connection back. Only the outermost close cleans up what was left
+// behind (statements, an open transaction), a nested one leaves them to its
+// caller. The connection stays open for the next request.
 int closeDatabase(sqlite3 *db) {
-    int rc;
-    sqlite3_stmt *stmt;
-
-    // Finalize all outstanding statements
-    while ((stmt = sqlite3_next_stmt(db, NULL)) != NULL) {
-        sqlite3_finalize(stmt);
+    ThreadDatabase *thread_db = pthread_getspecific(thread_database_key);
+    if (thread_db == NULL || thread_db->db != db) {
+        fprintf(stderr, "Error closing database: not the connection of this thread\n");
+        return FALSE;
     }
-
-    // Commit or rollback any outstanding transactions
-    if (sqlite3_get_autocommit(db) == 0) {
-        rc = sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
-        if (rc != SQLITE_OK) {
-            sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
-        }
+    if (thread_db->depth == 0) {
+        fprintf(stderr, "Error closing database: it is not open on this thread\n");
+        return FALSE;
     }
 
-    rc = sqlite3_close(db);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Error closing database: %s\n", sqlite3_errmsg(db));
-        return FALSE;
+    if (--thread_db->depth > 0) {
+        return TRUE;
     }
+    reset_thread_database(thread_db, TRUE);
     return TRUE;
 }
 
@@ -0,0 +1,188 @@
+/*
+ * Created on Fri Oct 16 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "Static_Cache.h"
+
+#define TRUE 1
+#define FALSE 0
+
+// Written once before the servers start, read only afterwards
+static StaticAsset *assets = NULL;
+static size_t num_assets = 0;
+
+static const char *guess_content_type(const char *file_name) {
+    const char *extension = strrchr(file_name, '.');
+    if (extension == NULL) {
+        return "application/octet-stream";
+    }
+    extension++;
+    if (strcasecmp(extension, "html") == 0 || strcasecmp(extension, "htm") == 0) {
+        return "text/html; charset=utf-8";
+    } else if (strcasecmp(extension, "css") == 0) {
+        return "text/css; charset=utf-8";
+    } else if (strcasecmp(extension, "js") == 0) {
+        return "text/javascript; charset=utf-8";
+    } else if (strcasecmp(extension, "json") == 0) {
+        return "application/json";
+    } else if (strcasecmp(extension, "png") == 0) {
+        return "image/png";
+    } else if (strcasecmp(extension, "gif") == 0) {
+        return "image/gif";
+    } else if (strcasecmp(extension, "jpg") == 0 || strcasecmp(extension, "jpeg") == 0) {
+        return "image/jpeg";
+    } else if (strcasecmp(extension, "svg") == 0) {
+        return "image/svg+xml";
+    }
+    return "application/octet-stream";
+}
+
+// The request path is lowercased before lookup, so keys are stored the same way
+// with anything outside the unreserved set percent-encoded (e.g. spaces as %20)
+static char *asset_url(const char *file_name) {
+    size_t prefix_length = strlen(STATIC_ASSETS_PREFIX);
+    char *url = malloc(prefix_length + strlen(file_name) * 3 + 1);
+    if (url == NULL) {
+        return NULL;
+    }
+    strcpy(url, STATIC_ASSETS_PREFIX);
+    char *out = url + prefix_length;
+    for (const unsigned char *c = (const unsigned char *) file_name; *c != '\0'; c++) {
+        if (isalnum(*c) || *c == '-' || *c == '_' || *c == '.' || *c == '~') {
+            *out++ = tolower(*c);
+        } else {
+            out += sprintf(out, "%%%02x", *c);
+        }
+    }
+    *out = '\0';
+    return url;
+}
+
+static char add_asset(const char *file_path, char *key) {
+    FILE *file = fopen(file_path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s\n", file_path);
+        free(key);
+        return FALSE;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    rewind(file);
+
+    char *data = malloc(file_size > 0 ? file_size : 1);
+    StaticAsset *grown = realloc(assets, sizeof(StaticAsset) * (num_assets + 1));
+    if (data == NULL || grown == NULL || (file_size > 0 && fread(data, 1, file_size, file) != (size_t) file_size)) {
+        fprintf(stderr, "Failed to load %s\n", file_path);
+        fclose(file);
+        free(data);
+        free(key);
+        if (grown != NULL) {
+            assets = grown;
+        }
+        return FALSE;
+    }
+    fclose(file);
+    assets = grown;
+
+    // FNV-1a over the contents, so the tag only changes when the file does
+    unsigned int hash = 2166136261u;
+    for (long i = 0; i < file_size; i++) {
+        hash ^= (unsigned char) data[i];
+        hash *= 16777619u;
+    }
+
+    StaticAsset *asset = &assets[num_assets++];
+    asset->key = key;
+    asset->data = data;
+    asset->length = file_size;
+    asset->content_type = guess_content_type(file_path);
+    snprintf(asset->etag, sizeof(asset->etag), "\"%08x-%lx\"", hash, file_size);
+    return TRUE;
+}
+
+static void load_directory(const char *directory, char is_template) {
+    DIR *dir = opendir(directory);
+    if (dir == NULL) {
+        fprintf(stderr, "Could not open the %s directory\n", directory);
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        // Skips ., .. and hidden files like .DS_Store
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        char file_path[512];
+        snprintf(file_path, sizeof(file_path), "%s/%s", directory, entry->d_name);
+        struct stat st;
+        if (stat(file_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+
+        char *key = is_template ? strdup(entry->d_name) : asset_url(entry->d_name);
+        if (key == NULL) {
+            fprintf(stderr, "Failed to allocate memory for %s\n", file_path);
+            continue;
+        }
+        if (add_asset(file_path, key) == TRUE) {
+            printf("Cached %s (%zu bytes)\n", file_path, assets[num_assets - 1].length);
+        }
+    }
+    closedir(dir);
+}
+
+char init_static_cache(void) {
+    load_directory(STATIC_TEMPLATES_DIR, TRUE);
+    load_directory(STATIC_ASSETS_DIR, FALSE);
+    return num_assets > 0 ? TRUE : FALSE;
+}
+
+void free_static_cache(void) {
+    for (size_t i = 0; i < num_assets; i++) {
+        free(assets[i].key);
+        free(assets[i].data);
+    }
+    free(assets);
+    assets = NULL;
+    num_assets = 0;
+}
+
+// A handful of files, a linear scan is cheaper than anything fancier
+const StaticAsset *static_cache_find(const char *key) {
+    for (size_t i = 0; i < num_assets; i++) {
+        if (strcmp(assets[i].key, key) == 0) {
+            return &assets[i];
+        }
+    }
+    return NULL;
+}
+
+// The body points into the cache, nothing is read or copied per request
+void serve_static_asset(const StaticAsset *asset, const char *if_none_match, HTTPResponse *response) {
+    http_response_reset(response);
+
+    if (if_none_match != NULL && (strcmp(if_none_match, "*") == 0 || strstr(if_none_match, asset->etag) != NULL)) {
+        http_response_status(response, 304, "Not Modified", NULL);
+    } else {
+        http_response_status(response, 200, "OK", asset->content_type);
+        http_response_body(response, asset->data, asset->length, NULL);
+    }
+    http_response_header(response, "ETag", asset->etag);
+    http_response_header(response, "Cache-Control", "no-cache");
+}
@@ -0,0 +1,81 @@
+/*
+ * Created on Sat Oct 17 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Timer_Wheel.h"
+
+void init_timer_wheel(TimerWheel *wheel, time_t now) {
+    memset(wheel->slots, 0, sizeof(wheel->slots));
+    wheel->last_tick = now;
+}
+
+void timer_node_init(TimerNode *node) {
+    node->deadline = 0;
+    node->slot = -1;
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+void timer_wheel_add(TimerWheel *wheel, TimerNode *node, time_t deadline) {
+    // A deadline already behind the wheel goes in the next slot to be checked
+    if (deadline <= wheel->last_tick) {
+        deadline = wheel->last_tick + 1;
+    }
+    node->deadline = deadline;
+    node->slot = (int) (deadline % TIMER_WHEEL_SLOTS);
+    node->prev = NULL;
+    node->next = wheel->slots[node->slot];
+    if (node->next != NULL) {
+        node->next->prev = node;
+    }
+    wheel->slots[node->slot] = node;
+}
+
+void timer_wheel_remove(TimerWheel *wheel, TimerNode *node) {
+    if (node->slot < 0) {
+        return;
+    }
+    if (node->prev != NULL) {
+        node->prev->next = node->next;
+    } else {
+        wheel->slots[node->slot] = node->next;
+    }
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    }
+    timer_node_init(node);
+}
+
+// Visits the slots of every second since the last call and hands each node
+// whose deadline has passed to expired, after taking it off the wheel.
+// Returns the number of expired nodes.
+int timer_wheel_expire(TimerWheel *wheel, time_t now, timer_fn expired, void *arg) {
+    int count = 0;
+    // After a long stall one full turn is enough to see every slot
+    if (now - wheel->last_tick > TIMER_WHEEL_SLOTS) {
+        wheel->last_tick = now - TIMER_WHEEL_SLOTS;
+    }
+
+    while (wheel->last_tick < now) {
+        wheel->last_tick++;
+        TimerNode *node = wheel->slots[wheel->last_tick % TIMER_WHEEL_SLOTS];
+        while (node != NULL) {
+            TimerNode *next = node->next;
+            if (node->deadline <= now) {
+                timer_wheel_remove(wheel, node);
+                expired(node, arg);
+                count++;
+            }
+            node = next;
+        }
+    }
+    return count;
+}
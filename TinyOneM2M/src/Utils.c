@@ -11,6 +11,7 @@
 #include "mqtt.h"
 #include "mongoose.h"
 #include <pthread.h>
+#include <stdatomic.h>
 #include "posix_sockets.h"
 
 extern int DAYS_PLUS_ET;
@@ -20,6 +21,26 @@ extern char BASE_RI[MAX_CONFIG_LINE_LENGTH];
 extern char BASE_RN[MAX_CONFIG_LINE_LENGTH];
 extern char BASE_CSI[MAX_CONFIG_LINE_LENGTH];
 extern char BASE_POA[MAX_CONFIG_LINE_LENGTH];
+extern int WORKER_THREADS;
+extern int WORKER_QUEUE_SIZE;
+extern int KEEPALIVE_TIMEOUT;
+extern int HEADER_TIMEOUT;
+extern int BODY_TIMEOUT;
+extern int WRITE_TIMEOUT;
+extern int LISTENERS;
+extern int LISTEN_BACKLOG;
+extern int DEFER_ACCEPT;
+extern int NODELAY;
+extern char SERVER_MODE[MAX_CONFIG_LINE_LENGTH];
+extern int MAX_CONNECTIONS;
+extern int MAX_INFLIGHT;
+extern int RETRY_AFTER;
+extern int ROUTE_CACHE_SIZE;
+extern int ROUTE_SNAPSHOT_INTERVAL;
+extern int ID_BLOCK_SIZE;
+extern int EXPIRY_INTERVAL;
+extern int EXPIRY_BATCH_SIZE;
+extern int MAX_REQUEST_SIZE;
 
 static int is_mqtt_connected = 0;
 static const char *s_url = NULL;        // URL for the HTTP request
@@ -88,6 +109,46 @@ void parse_config_line(char* line) {
             strcpy(BASE_CSI, value);
         } else if (strcmp(key, "BASE_POA") == 0) {
             strcpy(BASE_POA, value);
+        } else if (strcmp(key, "WORKER_THREADS") == 0) {
+            WORKER_THREADS = atoi(value);
+        } else if (strcmp(key, "WORKER_QUEUE_SIZE") == 0) {
+            WORKER_QUEUE_SIZE = atoi(value);
+        } else if (strcmp(key, "KEEPALIVE_TIMEOUT") == 0) {
+            KEEPALIVE_TIMEOUT = atoi(value);
+        } else if (strcmp(key, "HEADER_TIMEOUT") == 0) {
+            HEADER_TIMEOUT = atoi(value);
+        } else if (strcmp(key, "BODY_TIMEOUT") == 0) {
+            BODY_TIMEOUT = atoi(value);
+        } else if (strcmp(key, "WRITE_TIMEOUT") == 0) {
+            WRITE_TIMEOUT = atoi(value);
+        } else if (strcmp(key, "LISTENERS") == 0) {
+            LISTENERS = atoi(value);
+        } else if (strcmp(key, "LISTEN_BACKLOG") == 0) {
+            LISTEN_BACKLOG = atoi(value);
+        } else if (strcmp(key, "TCP_DEFER_ACCEPT") == 0) {
+            DEFER_ACCEPT = atoi(value);
+        } else if (strcmp(key, "TCP_NODELAY") == 0) {
+            NODELAY = strcmp(value, "true") == 0 ? TRUE : FALSE;
+        } else if (strcmp(key, "SERVER_MODE") == 0) {
+            strcpy(SERVER_MODE, value);
+        } else if (strcmp(key, "MAX_CONNECTIONS") == 0) {
+            MAX_CONNECTIONS = atoi(value);
+        } else if (strcmp(key, "MAX_INFLIGHT") == 0) {
+            MAX_INFLIGHT = atoi(value);
+        } else if (strcmp(key, "RETRY_AFTER") == 0) {
+            RETRY_AFTER = atoi(value);
+        } else if (strcmp(key, "ROUTE_CACHE_SIZE") == 0) {
+            ROUTE_CACHE_SIZE = atoi(value);
+        } else if (strcmp(key, "ROUTE_SNAPSHOT_INTERVAL") == 0) {
+            ROUTE_SNAPSHOT_INTERVAL = atoi(value);
+        } else if (strcmp(key, "ID_BLOCK_SIZE") == 0) {
+            ID_BLOCK_SIZE = atoi(value);
+        } else if (strcmp(key, "EXPIRY_INTERVAL") == 0) {
+            EXPIRY_INTERVAL = atoi(value);
+        } else if (strcmp(key, "EXPIRY_BATCH_SIZE") == 0) {
+            EXPIRY_BATCH_SIZE = atoi(value);
+        } else if (strcmp(key, "MAX_REQUEST_SIZE") == 0) {
+            MAX_REQUEST_SIZE = atoi(value);
         } else {
             printf("Unknown key: %s\n", key);
         }
@@ -113,7 +174,7 @@ void load_config_file(const char* filename) {
 }
 
 void generate_unique_id(char *id_str) {
-    static int counter = 0;
+    static atomic_uint counter = 0;
     
     // Get the current time
     time_t t = time(NULL);
@@ -122,7 +183,7 @@ void generate_unique_id(char *id_str) {
     pid_t pid = getpid();
     
     // Create the unique ID string
-    snprintf(id_str, MAX_CONFIG_LINE_LENGTH, "%lx%lx%x", (unsigned long) t, (unsigned long) pid, counter++);
+    snprintf(id_str, MAX_CONFIG_LINE_LENGTH, "%lx%lx%x", (unsigned long) t, (unsigned long) pid, atomic_fetch_add(&counter, 1));
 }
 
 char is_number(const char *str) {
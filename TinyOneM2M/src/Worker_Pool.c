@@ -0,0 +1,142 @@
+/*
+ * Created on Mon Oct 12 2026
+ *
+ * Author(s): Rafael Pereira (Rafael_Pereira_2000@hotmail.com)
+ *            Carla Mendes (carlasofiamendes@outlook.com)
+ *            Ana Cruz (anacassia.10@hotmail.com)
+ * Copyright (c) 2023 IPLeiria
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Worker_Pool.h"
+
+#define TRUE 1
+#define FALSE 0
+
+static void *worker_loop(void *arg) {
+    WorkerPool *pool = (WorkerPool *) arg;
+
+    while (TRUE) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->count == 0 && !pool->stopping) {
+            pthread_cond_wait(&pool->not_empty, &pool->lock);
+        }
+
+        if (pool->count == 0 && pool->stopping) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+
+        Task task = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+        pthread_cond_signal(&pool->not_full);
+        pthread_mutex_unlock(&pool->lock);
+
+        task.fn(task.arg);
+    }
+
+    return NULL;
+}
+
+char init_worker_pool(WorkerPool *pool, int num_threads, size_t queue_capacity) {
+    if (num_threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cores > 0 ? (int) cores : 1;
+    }
+    if (queue_capacity == 0) {
+        queue_capacity = 1;
+    }
+
+    memset(pool, 0, sizeof(WorkerPool));
+    pool->capacity = queue_capacity;
+    pool->queue = (Task *) malloc(sizeof(Task) * queue_capacity);
+    pool->threads = (pthread_t *) malloc(sizeof(pthread_t) * num_threads);
+    if (pool->queue == NULL || pool->threads == NULL) {
+        fprintf(stderr, "Failed to allocate the worker pool\n");
+        free(pool->queue);
+        free(pool->threads);
+        return FALSE;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->not_empty, NULL);
+    pthread_cond_init(&pool->not_full, NULL);
+
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_loop, pool) != 0) {
+            perror("pthread_create failed");
+            destroy_worker_pool(pool);
+            return FALSE;
+        }
+        pool->num_threads++;
+    }
+
+    printf("Worker pool started with %d threads (queue of %zu tasks)\n", pool->num_threads, pool->capacity);
+    return TRUE;
+}
+
+// Blocks the caller while the queue is full
+char worker_pool_submit(WorkerPool *pool, task_fn fn, void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->count == pool->capacity && !pool->stopping) {
+        pthread_cond_wait(&pool->not_full, &pool->lock);
+    }
+
+    if (pool->stopping) {
+        pthread_mutex_unlock(&pool->lock);
+        return FALSE;
+    }
+
+    size_t tail = (pool->head + pool->count) % pool->capacity;
+    pool->queue[tail].fn = fn;
+    pool->queue[tail].arg = arg;
+    pool->count++;
+    pthread_cond_signal(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+
+    return TRUE;
+}
+
+// Never blocks, returns FALSE right away when the queue is full
+char worker_pool_try_submit(WorkerPool *pool, task_fn fn, void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    if (pool->count == pool->capacity || pool->stopping) {
+        pthread_mutex_unlock(&pool->lock);
+        return FALSE;
+    }
+
+    size_t tail = (pool->head + pool->count) % pool->capacity;
+    pool->queue[tail].fn = fn;
+    pool->queue[tail].arg = arg;
+    pool->count++;
+    pthread_cond_signal(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+
+    return TRUE;
+}
+
+void destroy_worker_pool(WorkerPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = TRUE;
+    pthread_cond_broadcast(&pool->not_empty);
+    pthread_cond_broadcast(&pool->not_full);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->not_empty);
+    pthread_cond_destroy(&pool->not_full);
+    free(pool->queue);
+    free(pool->threads);
+    pool->queue = NULL;
+    pool->threads = NULL;
+    pool->num_threads = 0;
+}
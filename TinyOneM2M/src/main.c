@@ -19,7 +19,7 @@
 
 #include "Common.h"
 
-int client_socket;
+HTTP_Server http_server = { .socket = -1 };
 
 int DAYS_PLUS_ET = 0;
 int PORT = 8000;
@@ -28,11 +28,33 @@ char BASE_RI[MAX_CONFIG_LINE_LENGTH] = "";
 char BASE_RN[MAX_CONFIG_LINE_LENGTH] = "";
 char BASE_CSI[MAX_CONFIG_LINE_LENGTH] = "cse-1";
 char BASE_POA[MAX_CONFIG_LINE_LENGTH] = "";
+int WORKER_THREADS = 0;
+int WORKER_QUEUE_SIZE = 1024;
+int KEEPALIVE_TIMEOUT = 5;
+int HEADER_TIMEOUT = 10;
+int BODY_TIMEOUT = 30;
+int WRITE_TIMEOUT = 5;
+int LISTENERS = 0;
+int LISTEN_BACKLOG = 1024;
+int DEFER_ACCEPT = 1;
+int NODELAY = TRUE;
+char SERVER_MODE[MAX_CONFIG_LINE_LENGTH] = "native";
+int MAX_CONNECTIONS = 1000;
+int MAX_INFLIGHT = 512;
+int RETRY_AFTER = 1;
+int ROUTE_CACHE_SIZE = 10000;
+int ROUTE_SNAPSHOT_INTERVAL = 300;
+int ID_BLOCK_SIZE = 100;
+int EXPIRY_INTERVAL = 1;
+int EXPIRY_BATCH_SIZE = 100;
+int MAX_REQUEST_SIZE = 1048576;
 
 int main() {
 
-    // Register the SIGINT signal handler
-    signal(SIGINT, sigint_handler);
+    // Ctrl+C is handled on a thread of its own
+    if (init_signals() == FALSE) {
+        exit(EXIT_FAILURE);
+    }
 
 	load_config_file(".config");
 	if (DAYS_PLUS_ET == 0 || strcmp(BASE_RI, "") == 0 || strcmp(BASE_RN, "") == 0) {
@@ -40,62 +62,111 @@ int main() {
 		exit(EXIT_FAILURE);
 	}
 
-    pthread_t thread_id;
+    // Only one server may use the database, whichever mode it runs in
+    if (lock_instance("tiny-oneM2M.db.lock") < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    // cJSON allocates from the request arena while a request is being served
+    init_arena_hooks();
 
     // registering Routes
-    struct Route *head = NULL; // initialize the head pointer to NULL
-    head = addRoute(&head, "/", "", -1, "index.html"); // add the first node to the list
-    addRoute(&head, "/documentation", "", -1, "about.html"); // add the first node to the list
+    RouteTable routes;
+    if (init_route_table(&routes) == FALSE) {
+        exit(EXIT_FAILURE);
+    }
+    if (init_route_cache(ROUTE_CACHE_SIZE) == FALSE) {
+        exit(EXIT_FAILURE);
+    }
+    addRoute(&routes, "/", "", -1, "index.html"); // add the first node to the list
+    addRoute(&routes, "/documentation", "", -1, "about.html"); // add the first node to the list
 
-    short rs = init_protocol(&head);
+    short rs = init_protocol(&routes);
     if (rs == FALSE) {
 		perror("Error initializing protocol.");
         exit(EXIT_FAILURE);
     }
 
-    rs = init_routes(&head);
-    if (rs == FALSE) {
-		perror("Error initializing routes.");
+    // Resource IDs come from memory, the database is only scanned for them here
+    if (init_id_allocator() == FALSE) {
+        perror("Error initializing the resource ids.");
         exit(EXIT_FAILURE);
     }
 
+    // A snapshot matching the database saves scanning it
+    char snapshots = init_route_snapshots(&routes);
+    if (snapshots == FALSE || load_route_snapshot(&routes) == FALSE) {
+        rs = init_routes(&routes);
+        if (rs == FALSE) {
+            perror("Error initializing routes.");
+            exit(EXIT_FAILURE);
+        }
+        write_route_snapshot(&routes);
+    }
+
+    // templates and static/ are read once, requests are served from memory
+    if (init_static_cache() == FALSE) {
+        fprintf(stderr, "No templates or static files were loaded.\n");
+    }
+
     printf("\n====================================\n");
     printf("=========ALL AVAILABLE ROUTES========\n");
     // display all available routes
-    inorder(head);
+    inorder(&routes);
 
-    // initiate HTTP_Server
-    HTTP_Server http_server;
-    init_server(&http_server, PORT);
+    // The walk above is not in an epoch, so nothing may retire routes before it ends
+    start_route_snapshots(&routes);
 
-    // accept incoming client connections and handle them in separate threads
-    while (TRUE) {
-        client_socket = accept(http_server.socket, NULL, NULL);
-        if (client_socket < 0) {
-            perror("accept failed");
-            exit(EXIT_FAILURE);
-        }
+    // Resources past their et are deleted in the background
+    start_expiration_reaper(&routes);
 
-        ConnectionInfo* info = malloc(sizeof(ConnectionInfo));
-        if (info == NULL) {
-            perror("malloc failed");
+    // the Mongoose event loop serves everything from this thread
+    if (strcmp(SERVER_MODE, "mongoose") == 0) {
+        if (run_mongoose_server(PORT, &routes) == FALSE) {
+            perror("Error initializing mongoose server.");
             exit(EXIT_FAILURE);
         }
+        return 0;
+    } else if (strcmp(SERVER_MODE, "native") != 0) {
+        fprintf(stderr, "Unknown SERVER_MODE %s, should be native or mongoose\n", SERVER_MODE);
+        exit(EXIT_FAILURE);
+    }
 
-        info->socket_desc = client_socket;
-        info->route = head;
+    // initiate HTTP_Server
+    init_server(&http_server, PORT);
+
+    // connections are watched by the reactors and requests run on a fixed set of workers
+    WorkerPool pool;
+    if (init_worker_pool(&pool, WORKER_THREADS, WORKER_QUEUE_SIZE) == FALSE) {
+        perror("Error initializing worker pool.");
+        exit(EXIT_FAILURE);
+    }
 
-        if (pthread_create(&thread_id, NULL, handle_connection, (void*)info) < 0) {
-            perror("pthread_create failed");
+    // each listener gets its own reactor, so accepting scales with the cores
+    Reactor *reactors = (Reactor *) malloc(sizeof(Reactor) * http_server.num_sockets);
+    if (reactors == NULL) {
+        perror("Error allocating reactors.");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < http_server.num_sockets; i++) {
+        if (init_reactor(&reactors[i], http_server.sockets[i], &pool, &routes) == FALSE || start_reactor(&reactors[i]) == FALSE) {
+            perror("Error initializing reactor.");
             exit(EXIT_FAILURE);
         }
+    }
 
-        printf("New client connected, thread created for handling.\n");
+    for (int i = 0; i < http_server.num_sockets; i++) {
+        pthread_join(reactors[i].thread, NULL);
     }
+    destroy_worker_pool(&pool);
+    free(reactors);
+    close_server(&http_server);
+    free_static_cache();
 
     // Free allocated memory
-    free(head);
-    head = NULL;
+    stop_route_snapshots();
+    free_route_cache();
+    free_route_table(&routes);
 
     return 0;
 }
@@ -1,4 +1,5 @@
 import os
+import time
 import unittest
 import uuid
 from datetime import datetime, timedelta
@@ -152,6 +153,151 @@ class CNTvCINTestCase(unittest.TestCase):
         assert new_cnt_data["m2m:cnt"]["cbs"] == initial_cbs + len(new_cin_entity.con)
         assert new_cnt_data["m2m:cnt"]["st"] == initial_st
 
+    def create_cnt_with_cins(self, count, mni=None, mbs=None):
+        cnt_url = f"{self.base_url}/onem2m/{self.ae_rn}"
+        cnt_headers = {
+            "X-M2M-Origin": "admin:admin",
+            "Content-Type": "application/json;ty=3"
+        }
+        cnt_entity = CNT(mni=mni, mbs=mbs)
+        cnt_response = requests.post(cnt_url, headers=cnt_headers, json=cnt_entity.to_json())
+        assert cnt_response.status_code == 200
+        cnt_rn = cnt_response.json()["m2m:cnt"]["rn"]
+
+        url = f"{self.base_url}/onem2m/{self.ae_rn}/{cnt_rn}"
+        headers = {
+            "X-M2M-Origin": "admin:admin",
+            "Content-Type": "application/json;ty=4"
+        }
+        cin_rns = []
+        for i in range(count):
+            cin_entity = CIN(cnf="application/json", con=f"Content {i}")
+            response = requests.post(url, headers=headers, json=cin_entity.to_json())
+            assert response.status_code == 200
+            cin_rns.append(response.json()["m2m:cin"]["rn"])
+        return cnt_rn, cin_rns
+
+    def test_lower_mni_evicts_oldest_instances(self):
+        cnt_rn, cin_rns = self.create_cnt_with_cins(5)
+        url = f"{self.base_url}/onem2m/{self.ae_rn}/{cnt_rn}"
+        headers = {
+            "X-M2M-Origin": "admin:admin",
+            "Content-Type": "application/json;ty=3"
+        }
+
+        update_response = requests.put(url, headers=headers, json={"m2m:cnt": {"mni": 2}})
+        assert update_response.status_code == 200
+
+        cnt_response = requests.get(url, headers=headers)
+        assert cnt_response.status_code == 200
+        cnt_data = cnt_response.json()
+        assert cnt_data["m2m:cnt"]["mni"] == 2
+        assert cnt_data["m2m:cnt"]["cni"] == 2
+        assert cnt_data["m2m:cnt"]["cbs"] == len("Content 3") + len("Content 4")
+
+        # Only the two newest instances are left
+        for rn in cin_rns[:3]:
+            assert requests.get(f"{url}/{rn}", headers=headers).status_code == 404
+        for rn in cin_rns[3:]:
+            assert requests.get(f"{url}/{rn}", headers=headers).status_code == 200
+        oldest_response = requests.get(f"{url}/ol", headers=headers)
+        assert oldest_response.status_code == 200
+        assert oldest_response.json()["m2m:cin"]["rn"] == cin_rns[3]
+
+    def test_lower_mbs_evicts_oldest_instances(self):
+        cnt_rn, cin_rns = self.create_cnt_with_cins(4)
+        url = f"{self.base_url}/onem2m/{self.ae_rn}/{cnt_rn}"
+        headers = {
+            "X-M2M-Origin": "admin:admin",
+            "Content-Type": "application/json;ty=3"
+        }
+
+        # Room for two instances of 9 bytes, not three
+        update_response = requests.put(url, headers=headers, json={"m2m:cnt": {"mbs": 20}})
+        assert update_response.status_code == 200
+
+        cnt_response = requests.get(url, headers=headers)
+        assert cnt_response.status_code == 200
+        cnt_data = cnt_response.json()
+        assert cnt_data["m2m:cnt"]["mbs"] == 20
+        assert cnt_data["m2m:cnt"]["cni"] == 2
+        assert cnt_data["m2m:cnt"]["cbs"] == 18
+
+        for rn in cin_rns[:2]:
+            assert requests.get(f"{url}/{rn}", headers=headers).status_code == 404
+        for rn in cin_rns[2:]:
+            assert requests.get(f"{url}/{rn}", headers=headers).status_code == 200
+
+        # New instances keep being evicted against the lowered limit
+        cin_entity = CIN(cnf="application/json", con="Content 4")
+        cin_headers = {
+            "X-M2M-Origin": "admin:admin",
+            "Content-Type": "application/json;ty=4"
+        }
+        response = requests.post(url, headers=cin_headers, json=cin_entity.to_json())
+        assert response.status_code == 200
+        cnt_data = requests.get(url, headers=headers).json()
+        assert cnt_data["m2m:cnt"]["cni"] == 2
+        assert cnt_data["m2m:cnt"]["cbs"] == 18
+
+    def test_expired_cin_is_reaped(self):
+        cnt_rn, cin_rns = self.create_cnt_with_cins(1)
+        url = f"{self.base_url}/onem2m/{self.ae_rn}/{cnt_rn}"
+        headers = {
+            "X-M2M-Origin": "admin:admin",
+            "Content-Type": "application/json;ty=4"
+        }
+
+        short_et = (datetime.now() + timedelta(seconds=2)).strftime('%Y%m%dT%H%M%S')
+        cin_entity = CIN(cnf="application/json", con="Short lived", et=short_et)
+        response = requests.post(url, headers=headers, json=cin_entity.to_json())
+        assert response.status_code == 200
+        expiring_rn = response.json()["m2m:cin"]["rn"]
+        assert requests.get(f"{url}/{expiring_rn}", headers=headers).status_code == 200
+        assert requests.get(url, headers=headers).json()["m2m:cnt"]["cni"] == 2
+
+        # The reaper looks for expired resources every EXPIRY_INTERVAL seconds
+        deadline = time.time() + 15
+        while requests.get(f"{url}/{expiring_rn}", headers=headers).status_code != 404:
+            assert time.time() < deadline, "the expired CIN was not deleted"
+            time.sleep(0.5)
+
+        cnt_response = requests.get(url, headers=headers)
+        assert cnt_response.status_code == 200
+        cnt_data = cnt_response.json()
+        assert cnt_data["m2m:cnt"]["cni"] == 1
+        assert cnt_data["m2m:cnt"]["cbs"] == len("Content 0")
+        assert requests.get(f"{url}/{cin_rns[0]}", headers=headers).status_code == 200
+        latest_response = requests.get(f"{url}/la", headers=headers)
+        assert latest_response.status_code == 200
+        assert latest_response.json()["m2m:cin"]["rn"] == cin_rns[0]
+
+    def test_expired_cnt_is_reaped_with_its_instances(self):
+        cnt_url = f"{self.base_url}/onem2m/{self.ae_rn}"
+        cnt_headers = {
+            "X-M2M-Origin": "admin:admin",
+            "Content-Type": "application/json;ty=3"
+        }
+        short_et = (datetime.now() + timedelta(seconds=2)).strftime('%Y%m%dT%H%M%S')
+        cnt_response = requests.post(cnt_url, headers=cnt_headers, json=CNT(et=short_et).to_json())
+        assert cnt_response.status_code == 200
+        url = f"{cnt_url}/{cnt_response.json()['m2m:cnt']['rn']}"
+
+        headers = {
+            "X-M2M-Origin": "admin:admin",
+            "Content-Type": "application/json;ty=4"
+        }
+        response = requests.post(url, headers=headers, json=CIN(cnf="application/json", con="Content").to_json())
+        assert response.status_code == 200
+        cin_url = f"{url}/{response.json()['m2m:cin']['rn']}"
+
+        deadline = time.time() + 15
+        while requests.get(url, headers=headers).status_code != 404:
+            assert time.time() < deadline, "the expired CNT was not deleted"
+            time.sleep(0.5)
+        assert requests.get(cin_url, headers=headers).status_code == 404
+        assert requests.get(f"{url}/la", headers=headers).status_code == 404
+
 
 if __name__ == '__main__':
     unittest.main()
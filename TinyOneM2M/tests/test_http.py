@@ -0,0 +1,117 @@
+import json
+import os
+import re
+import socket
+import unittest
+from urllib.parse import urlparse
+
+import requests
+from dotenv import load_dotenv
+
+from tests.entities.AE import AE
+
+load_dotenv()
+
+
+class HTTPTestCase(unittest.TestCase):
+    base_url = os.getenv('BASE_URL')
+
+    def connect(self):
+        url = urlparse(self.base_url)
+        connection = socket.create_connection((url.hostname, url.port or 80))
+        connection.settimeout(5)
+        return connection
+
+    def receive_all(self, connection):
+        data = b""
+        try:
+            while True:
+                chunk = connection.recv(65536)
+                if not chunk:
+                    break
+                data += chunk
+        except (socket.timeout, ConnectionResetError):
+            pass
+        return data
+
+    def status_codes(self, data):
+        return [int(code) for code in re.findall(rb"HTTP/1\.1 (\d{3})", data)]
+
+    def test_chunked_request(self):
+        body = json.dumps(AE().to_json()).encode()
+        request = (b"POST /onem2m HTTP/1.1\r\n"
+                   b"Host: localhost\r\n"
+                   b"X-M2M-Origin: admin:admin\r\n"
+                   b"Content-Type: application/json;ty=2\r\n"
+                   b"Transfer-Encoding: chunked\r\n"
+                   b"Connection: close\r\n\r\n")
+        for start in range(0, len(body), 16):
+            chunk = body[start:start + 16]
+            request += b"%x\r\n" % len(chunk) + chunk + b"\r\n"
+        request += b"0\r\n\r\n"
+
+        connection = self.connect()
+        connection.sendall(request)
+        data = self.receive_all(connection)
+        connection.close()
+
+        assert self.status_codes(data) == [200]
+        response_data = json.loads(data.split(b"\r\n\r\n", 1)[1])
+        ae_rn = response_data["m2m:ae"]["rn"]
+
+        headers = {"X-M2M-Origin": "admin:admin"}
+        response = requests.get(f"{self.base_url}/onem2m/{ae_rn}", headers=headers)
+        assert response.status_code == 200
+
+    def test_pipelined_keep_alive_requests(self):
+        request = b"GET /onem2m HTTP/1.1\r\nHost: localhost\r\nX-M2M-Origin: admin:admin\r\n\r\n"
+        last_request = (b"GET /onem2m HTTP/1.1\r\nHost: localhost\r\nX-M2M-Origin: admin:admin\r\n"
+                        b"Connection: close\r\n\r\n")
+
+        # All requests go out in a single write, the server has to split them itself
+        connection = self.connect()
+        connection.sendall(request * 4 + last_request)
+        data = self.receive_all(connection)
+        connection.close()
+
+        assert self.status_codes(data) == [200] * 5
+
+    def test_oversized_content_length(self):
+        request = (b"POST /onem2m HTTP/1.1\r\n"
+                   b"Host: localhost\r\n"
+                   b"X-M2M-Origin: admin:admin\r\n"
+                   b"Content-Type: application/json;ty=2\r\n"
+                   b"Content-Length: 4194304\r\n\r\n"
+                   b"{\"m2m:ae\":")
+
+        connection = self.connect()
+        connection.sendall(request)
+        data = self.receive_all(connection)
+        connection.close()
+
+        assert self.status_codes(data) == [413]
+
+    def test_oversized_chunked_request(self):
+        request = (b"POST /onem2m HTTP/1.1\r\n"
+                   b"Host: localhost\r\n"
+                   b"X-M2M-Origin: admin:admin\r\n"
+                   b"Content-Type: application/json;ty=2\r\n"
+                   b"Transfer-Encoding: chunked\r\n\r\n")
+        chunk = b"10000\r\n" + b"a" * 0x10000 + b"\r\n"
+
+        connection = self.connect()
+        connection.sendall(request)
+        # The server may answer and close before the whole body is sent
+        try:
+            for _ in range(32):
+                connection.sendall(chunk)
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+        data = self.receive_all(connection)
+        connection.close()
+
+        assert self.status_codes(data) == [413]
+
+
+if __name__ == '__main__':
+    unittest.main()